@@ -0,0 +1,15 @@
+function s = bench_function_handles (n)
+  ## Calls through handles to local and anonymous functions
+
+  a = 0.5;
+  f = @(x) a * x + 1;
+  g = @square;
+  s = 0;
+  for k = 1:n
+    s = s + f (k) - g (mod (k, 7)) + feval (g, 2);
+  endfor
+endfunction
+
+function y = square (x)
+  y = x * x;
+endfunction
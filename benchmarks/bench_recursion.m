@@ -0,0 +1,16 @@
+function s = bench_recursion (n)
+  ## Calls of a recursive local function
+
+  s = 0;
+  for k = 1:n
+    s = s + fib (12);
+  endfor
+endfunction
+
+function r = fib (k)
+  if (k < 2)
+    r = k;
+  else
+    r = fib (k - 1) + fib (k - 2);
+  endif
+endfunction
@@ -0,0 +1,15 @@
+function s = bench_scalar_loop (n)
+  ## Nested loops of scalar arithmetic and comparisons
+
+  s = 0;
+  for i = 1:n
+    for j = 1:100
+      x = i * 0.5 + j;
+      if (mod (j, 3) == 0)
+        s = s + x / (j + 1);
+      else
+        s = s - x * 1e-3;
+      endif
+    endfor
+  endfor
+endfunction
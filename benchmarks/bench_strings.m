@@ -0,0 +1,23 @@
+function s = bench_strings (n)
+  ## Concatenation, comparison and switch on strings
+
+  words = {"alpha", "beta", "gamma", "delta", "epsilon"};
+  s = 0;
+  for k = 1:n
+    w = words{mod (k, numel (words)) + 1};
+    t = [w "_" num2str(mod (k, 10))];
+    switch (w)
+      case "alpha"
+        s = s + 1;
+      case {"beta", "gamma"}
+        s = s + numel (t);
+      otherwise
+        if (strcmp (t(1:2), "de"))
+          s = s + 3;
+        else
+          s = s - 1;
+        endif
+    endswitch
+    s = s + any (upper (t) == "A");
+  endfor
+endfunction
@@ -0,0 +1,20 @@
+function s = bench_struct_cell (n)
+  ## Field access of structs and growing and indexing of cell arrays
+
+  p.count = 0;
+  p.total = 0;
+  p.items = {};
+  for k = 1:n
+    p.count = p.count + 1;
+    p.total = p.total + k;
+    if (numel (p.items) < 32)
+      p.items{end+1} = struct ("id", k, "value", k * 2);
+    else
+      p.items{mod (k, 32) + 1}.value = k;
+    endif
+  endfor
+  s = p.total / p.count;
+  for k = 1:numel (p.items)
+    s = s + p.items{k}.value;
+  endfor
+endfunction
@@ -0,0 +1,12 @@
+function s = bench_vector_ops (n)
+  ## Element-wise operations, reductions and indexing of small vectors
+
+  x = linspace (0, 1, 64);
+  s = 0;
+  for k = 1:n
+    y = x .* k + sin (x);
+    y(y > 0.5 * k) = 0;
+    s = s + sum (y) + y(end) - y(1);
+    x(mod (k, 64) + 1) = 1 / k;
+  endfor
+endfunction
@@ -0,0 +1,178 @@
+function results = run_benchmarks (varargin)
+  ## RESULTS = run_benchmarks ()
+  ## RESULTS = run_benchmarks (OptionName, OptionValue, ...)
+  ##
+  ## Times the workloads bench_*.m of this directory in the interpreter and
+  ## compiled by octave2oct in each build mode. Each workload is called once
+  ## to load it and then timed 'repeat' times; the minimum time is reported.
+  ## The result of a compiled workload is compared to the result of the
+  ## interpreter.
+  ##
+  ## RESULTS is a struct array with the fields name, mode, n, time, speedup,
+  ## ok and message. mode is 'interpreter' or a build mode and speedup is the
+  ## time of the interpreter divided by the time of the mode.
+  ##
+  ## Options:
+  ##
+  ##   'names'   : all bench_*.m files (default) | cell array of names
+  ##   'modes'   : {'single', 'static'} (default) | cell array of build
+  ##               modes
+  ##   'repeat'  : 5 (default)
+  ##   'scale'   : 1 (default), multiplies the problem size of each workload
+  ##   'workdir' : tempname () (default), directory of the .oct files and
+  ##               the caches. It is removed at the end if it didn't exist
+  ##               before.
+  ##   'outfile' : '' (default) | name of a CSV file that the results are
+  ##               written to
+  ##
+  ## The 'dynamic' mode isn't run by default. Its .oct files need the
+  ## directory WORKDIR/cache_dynamic/bin in the library search path ('PATH',
+  ## 'LD_LIBRARY_PATH' or 'DYLD_LIBRARY_PATH') before the start of Octave,
+  ## otherwise they are reported as failed.
+  ##
+  ## Example:
+  ##
+  ##   run_benchmarks ('modes', {'single'}, 'outfile', 'results.csv')
+
+  benchdir = fileparts (mfilename ('fullpath'));
+  addpath (benchdir);
+
+  opts = struct ('names', {{}},
+                 'modes', {{'single', 'static'}},
+                 'repeat', 5,
+                 'scale', 1,
+                 'workdir', tempname (),
+                 'outfile', '');
+
+  if (mod (numel (varargin), 2) != 0)
+    error ('run_benchmarks: options should be pairs of names and values');
+  endif
+
+  for k = 1:2:numel (varargin)
+    if (! isfield (opts, varargin{k}))
+      error ('run_benchmarks: invalid option name %s', varargin{k});
+    endif
+    opts.(varargin{k}) = varargin{k+1};
+  endfor
+
+  if (isempty (opts.names))
+    files = dir (fullfile (benchdir, 'bench_*.m'));
+    [~, opts.names] = cellfun (@fileparts, {files.name}, 'UniformOutput', false);
+  endif
+
+  ## problem sizes that take a fraction of a second in the interpreter
+
+  sizes = struct ('bench_scalar_loop', 2000,
+                  'bench_vector_ops', 20000,
+                  'bench_struct_cell', 20000,
+                  'bench_recursion', 50,
+                  'bench_strings', 5000,
+                  'bench_function_handles', 20000);
+
+  new_workdir = ! exist (opts.workdir, 'dir');
+  if (new_workdir)
+    mkdir (opts.workdir);
+  endif
+  addpath (opts.workdir);
+  unwind_protect
+
+    results = struct ('name', {}, 'mode', {}, 'n', {}, 'time', {},
+                      'speedup', {}, 'ok', {}, 'message', {});
+
+    for i = 1:numel (opts.names)
+      name = opts.names{i};
+
+      if (isfield (sizes, name))
+        n = round (sizes.(name) * opts.scale);
+      else
+        n = round (1000 * opts.scale);
+      endif
+
+      [t_interp, expected] = time_call (name, n, opts.repeat);
+      results(end+1) = result (name, 'interpreter', n, t_interp, 1, true, '');
+      printf ('%-24s %-12s %10.4f s\n', name, 'interpreter', t_interp);
+
+      for j = 1:numel (opts.modes)
+        mode = opts.modes{j};
+        outname = [name '_' mode];
+
+        try
+          args = {'outname', outname, 'outdir', opts.workdir, 'mode', mode};
+          if (! strcmp (mode, 'single'))
+            args = [args, {'cache', fullfile(opts.workdir, ['cache_' mode])}];
+          endif
+          octave2oct (name, args{:});
+
+          [t, value] = time_call (outname, n, opts.repeat);
+          ok = isequal (size (value), size (expected))
+               && all (abs (value(:) - expected(:)) <= 1e-10 * max (1, abs (expected(:))));
+          msg = '';
+          if (! ok)
+            msg = 'result differs from the interpreter';
+          endif
+          results(end+1) = result (name, mode, n, t, t_interp / t, ok, msg);
+          printf ('%-24s %-12s %10.4f s %8.2fx%s\n', name, mode, t, t_interp / t,
+                  ifelse_str (ok, '', '  (wrong result)'));
+        catch err
+          results(end+1) = result (name, mode, n, NaN, NaN, false, err.message);
+          printf ('%-24s %-12s failed: %s\n', name, mode, err.message);
+        end_try_catch
+      endfor
+    endfor
+
+    if (! isempty (opts.outfile))
+      write_csv (opts.outfile, results);
+    endif
+
+  unwind_protect_cleanup
+    rmpath (opts.workdir);
+    if (new_workdir)
+      confirm_recursive_rmdir (false, 'local');
+      [status, msg] = rmdir (opts.workdir, 's');
+      if (! status)
+        warning ('run_benchmarks: cannot remove %s: %s', opts.workdir, msg);
+      endif
+    endif
+  end_unwind_protect
+
+endfunction
+
+function [t, value] = time_call (name, n, repeat)
+  value = feval (name, n);
+  t = Inf;
+  for k = 1:repeat
+    t0 = tic ();
+    feval (name, n);
+    t = min (t, toc (t0));
+  endfor
+endfunction
+
+function r = result (name, mode, n, time, speedup, ok, message)
+  r = struct ('name', name, 'mode', mode, 'n', n, 'time', time,
+              'speedup', speedup, 'ok', ok, 'message', message);
+endfunction
+
+function str = ifelse_str (cond, a, b)
+  if (cond)
+    str = a;
+  else
+    str = b;
+  endif
+endfunction
+
+function write_csv (filename, results)
+  fid = fopen (filename, 'w');
+  if (fid < 0)
+    error ('run_benchmarks: cannot open %s', filename);
+  endif
+  unwind_protect
+    fprintf (fid, 'octave_version,name,mode,n,time,speedup,ok,message\n');
+    for k = 1:numel (results)
+      r = results(k);
+      fprintf (fid, '%s,%s,%s,%d,%.6g,%.4g,%d,"%s"\n', OCTAVE_VERSION, r.name,
+               r.mode, r.n, r.time, r.speedup, r.ok, strrep (r.message, '"', '""'));
+    endfor
+  unwind_protect_cleanup
+    fclose (fid);
+  end_unwind_protect
+endfunction
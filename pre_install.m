@@ -10,9 +10,13 @@ function pre_install (in)
       'coder_file'
       'coder_symtab'
       'lvalue_checker'
+      'type_analyser'
+      'parfor_analyser'
+      'constant_folder'
       'semantic_analyser'
       'code_generator'
       'coder_runtime'
+      'job_scheduler'
       'build_system'
       'octave2oct'
     };
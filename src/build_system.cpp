@@ -1,5 +1,7 @@
 #include <cctype>
+#include <cstdint>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <ostream>
 
@@ -28,6 +30,7 @@
 #include "coder_runtime.h"
 #include "coder_symtab.h"
 #include "dgraph.h"
+#include "job_scheduler.h"
 #include "semantic_analyser.h"
 
 #if OCTAVE_MAJOR_VERSION >= 7
@@ -45,6 +48,43 @@ namespace coder_compiler
     return str + "_";
   }
 
+  // 64 bit FNV-1a hash used to detect changes in the content of the generated
+  // translation units
+
+  static std::string
+  content_hash (const std::string& str)
+  {
+    uint64_t h = 14695981039346656037ULL;
+
+    for (unsigned char c : str)
+      {
+        h ^= c;
+
+        h *= 1099511628211ULL;
+      }
+
+    std::stringstream ss;
+
+    ss << std::hex << std::setw (16) << std::setfill ('0') << h;
+
+    return ss.str ();
+  }
+
+  static std::string
+  read_file (const std::string& filename)
+  {
+    std::ifstream is (filename, std::ios::in | std::ios::binary);
+
+    if (! is.good ())
+      return "";
+
+    std::stringstream ss;
+
+    ss << is.rdbuf ();
+
+    return ss.str ();
+  }
+
   void
   printgraph(const dgraph& G)
   {
@@ -307,7 +347,9 @@ namespace coder_compiler
     bool debug,
     bool keepcc,
     bool verbose,
-    const std::string& compiler_options
+    const std::string& compiler_options,
+    int jobs,
+    bool profile
   )
   {
     struct build_option
@@ -453,7 +495,7 @@ namespace coder_compiler
             else
               octave_stdout << "\nupdating dependencies of \"" << opt.sym_name << "\" ...\n";
           }
-        build (opt.file, opt.sym_name, opt.mkoct, opt.mkoct_bridge, opt.out_name, opt.out_dir, debug, keepcc, verbose, compiler_options);
+        build (opt.file, opt.sym_name, opt.mkoct, opt.mkoct_bridge, opt.out_name, opt.out_dir, debug, keepcc, verbose, compiler_options, jobs, profile);
       }
 
     if (mode == bm_dynamic )
@@ -483,7 +525,9 @@ namespace coder_compiler
     bool debug,
     bool keepcc,
     bool verbose,
-    const std::string& compiler_options
+    const std::string& compiler_options,
+    int jobs,
+    bool profile
   )
   {
     auto quote = [](const std::string& str) ->std::string
@@ -557,6 +601,39 @@ namespace coder_compiler
     if (! compiler_options.empty ())
       coptions = compiler_options;
 
+    // the generated code and the precompiled header only contain the
+    // counters of the profiler when CODER_PROFILE is defined
+
+    if (profile)
+      coptions += " -DCODER_PROFILE";
+
+    // An object file is reused when the hash of its translation unit, the
+    // compiler flags and the Octave version is the same as the hash that is
+    // stored next to it. So regenerating an unchanged file doesn't trigger
+    // recompilation.
+
+    std::string flags_key = std::string (OCTAVE_VERSION) + "\n" + dbg + "\n" + coptions + "\n";
+
+    std::string runtime_header_key = content_hash (runtime_header ());
+
+    std::vector<std::pair<std::string, std::string>> object_hashes;
+
+    auto object_hash_changed = [&](const std::string& obj, const std::string& key)->bool
+    {
+      std::string stamp = obj + ".hash";
+
+      octave::sys::file_stat obj_stat (obj);
+
+      if (obj_stat.exists () && read_file (stamp) == key)
+        return false;
+
+      octave::sys::unlink (stamp);
+
+      object_hashes.emplace_back (stamp, key);
+
+      return true;
+    };
+
     auto generate = [&](const coder_file_ptr& file, bool iscyclic = false)->void
     {
       if ( mode == bm_single || analyser.should_generate (file))
@@ -600,116 +677,328 @@ namespace coder_compiler
       std::function<void ()> m_fcn;
     };
 
-    auto init = [&]()
+    auto compile_command = [&](const std::string& obj, const std::string& cpp)->build_job::command
     {
-      std::string filename = "coder";
+      return {
+        quote("-o " + obj),
+        quote("-std=gnu++11"),
+        "-fPIC",
+        "-c",
+        dbg,
+        quote("-I" + incdir),
+        coptions,
+        quote(cpp)
+      };
+    };
 
-      std::string h = concat(incdir, filename + ".h" );
+    job_scheduler scheduler (jobs, verbose);
 
-      std::string cpp = concat(srcdir, filename + ".cpp" );
+    // "coder.h" is the first header that is included in each generated
+    // translation unit so it is precompiled to speed up the compilation of
+    // the cache. The precompiled header is rebuilt when the runtime, the
+    // compiler flags or the Octave version are changed. It is only created
+    // for GCC, other compilers use the plain header.
 
-      std::string obj = concat(libdir, filename + ".o" );
+    auto precompile_header = [&](const std::string& h)
+    {
+      auto config = [](const std::string& var)->std::string
+      {
+        octave_value_list ret = octave::feval ("mkoctfile", ovl (octave_value ("-p"), octave_value (var)), 2);
 
-      std::string bin = concat(bindir, "lib" + filename + shared_ext );
+        std::string val = ret(0).string_value ();
 
-      octave::sys::file_stat h_stat (h);
+        while (! val.empty () && std::isspace (static_cast<unsigned char> (val.back ())))
+          val.pop_back ();
+
+        return val;
+      };
+
+      std::string gch = h + ".gch";
+
+      std::string cxx = config ("CXX");
+
+      if (ismac || cxx.find ("g++") == std::string::npos)
+        {
+          octave::sys::unlink (gch);
+
+          return;
+        }
+
+      std::string cmd = cxx
+        + " -x c++-header "
+        + config ("CPPFLAGS") + " "
+        + config ("CXXPICFLAG") + " "
+        + config ("ALL_CXXFLAGS") + " "
+        + "-std=gnu++11 -fPIC " + dbg + " " + coptions + " "
+        + quote("-I" + incdir) + " "
+        + quote(h) + " -o " + quote(gch);
 
-      octave::sys::file_stat c_stat (cpp);
+      std::string key = content_hash (flags_key + runtime_header_key + cmd);
 
-      octave::sys::file_stat o_stat (obj);
+      octave::sys::file_stat gch_stat (gch);
 
-      octave::sys::file_stat d_stat (bin);
+      if (gch_stat.exists () && read_file (gch + ".hash") == key)
+        return;
+
+      octave::sys::unlink (gch + ".hash");
 
-      bool recompile = ! h_stat.exists () || ! c_stat.exists () || ! o_stat.exists ();
+      if (verbose)
+        octave_stdout << "  precompiling coder.h\n";
 
-      bool relink = mode == bm_dynamic && (recompile || ! d_stat.exists ());
+      octave_value_list ret = octave::feval ("system", ovl (octave_value (cmd)), 2);
 
-      if (! h_stat.exists () || ! c_stat.exists ())
+      if (ret(0).int_value () != 0)
         {
-            std::ofstream header(h);
+          // compilation proceeds without the precompiled header
 
-            header << "#pragma once\n";
+          octave::sys::unlink (gch);
 
-            header << runtime_header ();
+          return;
+        }
 
-            header.close ();
+      std::ofstream os (gch + ".hash", std::ios::out | std::ios::binary);
+
+      os << key;
+    };
+
+    // The runtime is compiled once per Octave version, runtime source and
+    // compiler flags into a directory that is shared by all of the caches
+    // and by the single mode builds.
+
+    std::string runtime_key = content_hash (flags_key + runtime_header () + runtime_source ());
 
-            std::ofstream source(cpp);
+    std::string runtime_dir = tilde_expand (concat (concat ("~", ".octave-coder"),
+      "runtime-" + std::string (OCTAVE_VERSION) + "-" + runtime_key));
 
-            source << "#define CODER_BUILDMODE_NOT_SINGLE 1\n";
+    std::string runtime_obj = concat (runtime_dir, "coder.o");
 
-            source << runtime_source ();
+    // Several Octave sessions may build the runtime at the same time, so the
+    // files of the runtime directory are written under unique names and then
+    // renamed. A rename replaces a file atomically so a session never reads
+    // a file that another session is writing.
 
-            source.close ();
+    auto rename_file = [](const std::string& from, const std::string& to)
+    {
+      std::string msg;
+
+      if (octave::sys::rename (from, to, msg) < 0)
+        error("coder: failed to rename %s to %s - %s", from.c_str (), to.c_str (), msg.c_str ());
+    };
+
+    auto replace_file = [&](const std::string& file, const std::string& content)
+    {
+      std::string tmp = octave::sys::tempnam (runtime_dir, "coder");
+
+      {
+        std::ofstream os (tmp, std::ios::out | std::ios::binary);
+
+        os << content;
+      }
+
+      unwind remove_tmp ([&]() { octave::sys::unlink (tmp); });
+
+      rename_file (tmp, file);
+    };
+
+    // A runtime directory is left behind when the Octave version, the
+    // runtime or the compiler flags change. The stamp of a runtime is
+    // refreshed once a day when it is used, and the runtime directories
+    // whose stamps are older than runtime_lifetime are removed whenever a
+    // new runtime is built.
+
+    const double day = 24 * 60 * 60;
+
+    const double runtime_lifetime = 30 * day;
+
+    auto stale_stamp = [](const std::string& stamp, double age)
+    {
+      octave::sys::file_stat fs (stamp);
+
+      if (! (fs && fs.exists ()))
+        return true;
+
+      return octave::sys::time ().double_value () - fs.mtime ().double_value () > age;
+    };
+
+    auto prune_runtimes = [&]()
+    {
+      std::string root = tilde_expand (concat ("~", ".octave-coder"));
+
+      octave::sys::dir_entry dir (root);
+
+      if (! dir)
+        return;
+
+      string_vector flist = dir.read ();
+
+      for (octave_idx_type i = 0; i < flist.numel (); i++)
+        {
+          std::string fname = flist[i];
+
+          std::string full_name = concat (root, fname);
+
+          if (fname.compare (0, 8, "runtime-") != 0 || full_name == runtime_dir)
+            continue;
+
+          octave::sys::file_stat fs (full_name);
+
+          if (! (fs && fs.is_dir ())
+              || ! stale_stamp (concat (full_name, "coder.o.hash"), runtime_lifetime))
+            continue;
+
+          std::string msg;
+
+          if (octave::sys::recursive_rmdir (full_name, msg) < 0)
+            warning ("coder: failed to remove the old runtime directory %s - %s",
+                     full_name.c_str (), msg.c_str ());
+          else if (verbose)
+            octave_stdout << "  removed the old runtime directory " << full_name << "\n";
         }
+    };
 
-      if (recompile)
+    auto prebuilt_runtime = [&]()->std::vector<size_t>
+    {
+      for (const auto& dir : {tilde_expand (concat ("~", ".octave-coder")), runtime_dir})
         {
-          if (verbose)
-            octave_stdout << "  compiling coder runtime\n";
+          octave::sys::file_stat fs (dir);
 
-          call_mkoctfile (
-            ovl(
-            octave_value( quote("-o " + obj)),
-            octave_value(quote("-std=gnu++11")),
-            octave_value("-fPIC"),
-            octave_value("-c"),
-            octave_value(dbg),
-            octave_value(quote("-I" + incdir)),
-            octave_value (coptions),
-            octave_value(quote(cpp))
-           ));
+          if (!(fs && fs.exists () && fs.is_dir ()))
+            {
+              std::string msg;
+
+              int status = octave::sys::mkdir (dir, 0777, msg);
+
+              if (status < 0)
+                error("coder: failed to create the runtime directory - %s", msg.c_str());
+            }
         }
 
-      if (relink)
+      std::string stamp = runtime_obj + ".hash";
+
+      octave::sys::file_stat obj_stat (runtime_obj);
+
+      if (obj_stat.exists () && read_file (stamp) == runtime_key)
         {
-          OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(SH_LDFLAGS) ));
+          if (stale_stamp (stamp, day))
+            replace_file (stamp, runtime_key);
 
-          unwind unw ([&](){OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(DL_LDFLAGS)));});
+          return {};
+        }
 
-          call_mkoctfile (
-            ovl(
-            octave_value(quote(obj)),
-            octave_value("-Wl,--output," + quote(bin) + strpl)
-            ));
+      std::string h = concat(runtime_dir, "coder.h" );
+
+      std::string header_text = "#pragma once\n" + runtime_header ();
+
+      if (read_file (h) != header_text)
+        replace_file (h, header_text);
+
+      std::string tmp = octave::sys::tempnam (runtime_dir, "coder");
+
+      std::string tmp_cpp = tmp + ".cpp";
+
+      std::string tmp_obj = tmp + ".o";
+
+      unwind remove_tmp ([&]()
+        {
+          octave::sys::unlink (tmp_cpp);
+
+          octave::sys::unlink (tmp_obj);
+        });
+
+      {
+        std::ofstream source (tmp_cpp, std::ios::out | std::ios::binary);
+
+        source << "#define CODER_BUILDMODE_NOT_SINGLE 1\n";
+
+        source << runtime_source ();
+      }
+
+      // the runtime is built before the other jobs are scheduled because it
+      // is only renamed to its shared name after it is compiled
+
+      job_scheduler runtime_scheduler (1, verbose);
+
+      runtime_scheduler.add_job ("compiling coder runtime", {compile_command (tmp_obj, tmp_cpp)});
+
+      runtime_scheduler.run ();
+
+      rename_file (tmp_cpp, concat(runtime_dir, "coder.cpp" ));
+
+      rename_file (tmp_obj, runtime_obj);
+
+      replace_file (stamp, runtime_key);
+
+      prune_runtimes ();
+
+      return {};
+    };
+
+    auto init = [&](const std::vector<size_t>& prebuilt_jobs)->std::vector<size_t>
+    {
+      std::string filename = "coder";
+
+      std::string h = concat(incdir, filename + ".h" );
+
+      std::string bin = concat(bindir, "lib" + filename + shared_ext );
+
+      octave::sys::file_stat h_stat (h);
+
+      if (! h_stat.exists () || read_file (h + ".hash") != runtime_header_key)
+        {
+            std::ofstream header(h);
+
+            header << "#pragma once\n";
+
+            header << runtime_header ();
+
+            header.close ();
+
+            std::ofstream stamp (h + ".hash", std::ios::out | std::ios::binary);
+
+            stamp << runtime_header_key;
+        }
+
+      precompile_header (h);
+
+      std::vector<size_t> runtime_jobs = prebuilt_jobs;
+
+      if (mode == bm_dynamic && object_hash_changed (bin, runtime_key))
+        {
+          runtime_jobs = {scheduler.add_job (
+            "linking lib" + filename + shared_ext,
+            {{quote(runtime_obj), "-Wl,--output," + quote(bin) + strpl}},
+            runtime_jobs,
+            true
+          )};
         }
+
+      return runtime_jobs;
     };
 
+    // compile jobs of the files that are recompiled in this build
+
+    std::map<coder_file_ptr, size_t> compile_jobs;
+
     auto compile =[&](const coder_file_ptr& file)
     {
       std::string filename = mangle(lowercase (file->name)) + std::to_string(file->id) ;
 
       std::string obj = concat(libdir, filename + ".o" );
 
-      octave::sys::file_stat obj_stat (obj);
+      std::string cpp = concat(srcdir, filename + ".cpp" );
 
-      file_time obj_time (obj);
+      std::string key = flags_key + runtime_header_key + read_file (cpp) + read_file (concat(incdir, filename + ".h" ));
 
-      if (analyser.should_generate (file)
-          || ! obj_stat.exists () )
-        {
-          if (verbose)
-            {
-              octave_stdout << "  compiling " << filename  << ".o\n";
-            }
-
-          std::string cpp = concat(srcdir, filename + ".cpp" );
+      for(const auto& f: analyser.dependency ().at(file) )
+        key += read_file (concat(incdir, mangle(lowercase (f->name)) + std::to_string(f->id) + ".h" ));
 
-          call_mkoctfile (
-            ovl(
-            octave_value( quote("-o " + obj)),
-            octave_value(quote("-std=gnu++11")),
-            octave_value("-fPIC"),
-            octave_value("-c"),
-            octave_value(dbg),
-            octave_value(quote("-I" + incdir)),
-            octave_value (coptions),
-            octave_value(quote(cpp))
-          ));
+      if (object_hash_changed (obj, content_hash (key)))
+        {
+          compile_jobs[file] = scheduler.add_job ("compiling " + filename + ".o", {compile_command (obj, cpp)});
         }
     };
 
-    auto forward_link = [&] (const coder_file_ptr& file)->bool
+    auto forward_link = [&] (const coder_file_ptr& file)->std::vector<size_t>
     {
       std::string filename = mangle(lowercase (file->name)) + std::to_string(file->id) ;
 
@@ -727,39 +1016,25 @@ namespace coder_compiler
 
       file_time bin_time (bin);
 
-      if (  analyser.should_generate (file)   // forward link (to avoid circular dependency problems when building in dynamic mode)
+      if (  compile_jobs.count (file)   // forward link (to avoid circular dependency problems when building in dynamic mode)
         ||  ! bin_stat.exists ()
         ||  obj_time.is_newer (bin_time.mtime ()))
         {
-          call_mkoctfile (
-            ovl(
-            octave_value( quote("-o " + tmpobj)),
-            octave_value(quote("-std=gnu++11")),
-            octave_value("-fPIC"),
-            octave_value("-c"),
-            octave_value(dbg),
-            octave_value(quote("-I" + incdir)),
-            octave_value (coptions),
-            octave_value(quote(cpp))
-             )
-          );
-
-          OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(SH_LDFLAGS) ));
-
-          unwind unw ([&](){OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(DL_LDFLAGS)));});
-
-          call_mkoctfile (
-            ovl( octave_value (quote(tmpobj)),
-            octave_value("-Wl,--output," + quote(bin) + strpl)
-            ) );
-
-          return true;
+          return {scheduler.add_job (
+            "forward linking " + filename + shared_ext,
+            {
+              compile_command (tmpobj, cpp),
+              {quote(tmpobj), "-Wl,--output," + quote(bin) + strpl}
+            },
+            {},
+            true
+          )};
         }
 
-      return false;
+      return {};
     };
 
-    auto link =[&](const coder_file_ptr& file, bool force = false)
+    auto link =[&](const coder_file_ptr& file, bool force, const std::vector<size_t>& deps)->std::vector<size_t>
     {
       std::string filename = mangle(lowercase (file->name)) + std::to_string(file->id) ;
 
@@ -773,36 +1048,35 @@ namespace coder_compiler
 
       file_time obj_time (obj);
 
+      auto compiled = compile_jobs.find (file);
+
       if ( force ||
-           analyser.should_generate (file)
+           compiled != compile_jobs.end ()
         || ! bin_stat.exists ()
         || obj_time.is_newer (bin_time.mtime ())
         )
         {
-          if (verbose)
-            {
-              octave_stdout << "  linking " << filename + shared_ext << "\n";
-            }
-
-          octave_value_list dep_names = ovl (octave_value ("-lcoder"));
+          build_job::command cmd {
+            "-Wl,-o," + quote(bin) + strpl,
+            quote(obj),
+            quote("-L" + bindir),
+            "-lcoder"
+          };
 
           for(const auto& f: analyser.dependency ().at(file) )
             {
-              dep_names.append ( octave_value ("-l" + mangle(lowercase (f->name)) + std::to_string(f->id)));
+              cmd.push_back ("-l" + mangle(lowercase (f->name)) + std::to_string(f->id));
             }
 
-          OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(SH_LDFLAGS) ));
+          std::vector<size_t> link_deps = deps;
 
-          unwind unw ([&](){OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(DL_LDFLAGS)));});
+          if (compiled != compile_jobs.end ())
+            link_deps.push_back (compiled->second);
 
-          call_mkoctfile (
-            ovl(
-            octave_value("-Wl,-o," + quote(bin) + strpl),
-            octave_value(quote(obj)),
-            octave_value(quote("-L" + bindir))
-            ).append (dep_names)
-          );
+          return {scheduler.add_job ("linking " + filename + shared_ext, {cmd}, link_deps, true)};
         }
+
+      return {};
     };
 
     auto make_oct_bridge =[&](const coder_file_ptr& file, const std::string& sym_name)
@@ -895,6 +1169,27 @@ namespace coder_compiler
 
       std::string cc = concat (out_dir, out_name  + ".cc");
 
+      // A profiled .oct file also defines coder_profile_<name> that is made
+      // callable by the first call of its function. The name is distinct so
+      // that the profiles of all of the profiled .oct files are accessible.
+
+      std::string profile_entry;
+
+      std::string profile_fcn;
+
+      if (profile)
+        {
+          std::string accessor = "coder_profile_" + out_name;
+
+          profile_entry = "  static const bool profile_loaded = profile_autoload ("
+            + quote(out_name) + ", " + quote(accessor) + ");\n";
+
+          profile_fcn = "\nDEFCODER_DLD (" + accessor + ", interp, args, nargout,"
+            + quote("S = " + accessor + " () returns the profile of the compiled functions of "
+                    + out_name + " and " + accessor + " ('clear') resets it.")
+            + ",\n{\n  return profile_report (args);\n})";
+        }
+
       std::string obj = concat (out_dir, out_name  + ".o");
 
       std::string oct = concat (out_dir, out_name + ".oct") ;
@@ -910,9 +1205,8 @@ namespace coder_compiler
           oct_os
             << "#include <octave/oct.h>" << "\n"
             << "#include \"interpreter.h\"\n"
-            << runtime_header()
-            << runtime_source()
-            << "\nusing namespace coder;\n"
+            << "#include" << quote("coder.h") << "\n"
+            << "using namespace coder;\n"
             << header.str()
             << source.str()
             << "DEFCODER_DLD ("
@@ -920,11 +1214,13 @@ namespace coder_compiler
             << ", interp, args, nargout,"
             << quote(out_name)
             << ",\n{\n"
+            << profile_entry
             << "  return "
             << nsname
             << "::"
             <<  mangle(sym_name)
-            << "make().get_value()->function_value()->call(interp.get_evaluator(),nargout,args);\n})";
+            << "make().get_value()->function_value()->call(interp.get_evaluator(),nargout,args);\n})"
+            << profile_fcn;
 
           oct_os.close();
 
@@ -935,6 +1231,7 @@ namespace coder_compiler
             octave_value("-fPIC"),
             octave_value("-c"),
             octave_value(dbg),
+            octave_value(quote("-I" + runtime_dir)),
             octave_value (coptions),
             octave_value(quote(cc))
 
@@ -945,6 +1242,7 @@ namespace coder_compiler
             octave_value("-o"),
             octave_value(quote(oct)),
             octave_value(quote (obj)),
+            octave_value(quote (runtime_obj)),
             octave_value(strp)
              )
           );
@@ -969,17 +1267,19 @@ namespace coder_compiler
             << ", interp, args, nargout,"
             << quote(out_name)
             << ",\n{\n"
+            << profile_entry
             << "  return "
             << nsname
             << "::"
             <<  mangle(sym_name)
-            << "make().get_value()->function_value()->call(interp.get_evaluator(),nargout,args);\n})";
+            << "make().get_value()->function_value()->call(interp.get_evaluator(),nargout,args);\n})"
+            << profile_fcn;
 
           oct_os.close ();
 
           obj_files.push_back (quote (obj));
 
-          obj_files.push_back (quote (concat (libdir, "coder.o")));
+          obj_files.push_back (quote (runtime_obj));
 
           for (const auto& entry : dependency )
             {
@@ -1028,11 +1328,13 @@ namespace coder_compiler
             << ", interp, args, nargout,"
             << quote(out_name)
             << ",\n{\n"
+            << profile_entry
             << "  return "
             << bridge_nsname
             << "::"
             <<  mangle(sym_name)
-            << "make().get_value()->function_value()->call(interp.get_evaluator(),nargout,args);\n})";
+            << "make().get_value()->function_value()->call(interp.get_evaluator(),nargout,args);\n})"
+            << profile_fcn;
 
           oct_os.close ();
 
@@ -1105,9 +1407,11 @@ namespace coder_compiler
           }
       }
 
+    std::vector<size_t> runtime_jobs = prebuilt_runtime ();
+
     if (mode != bm_single)
       {
-        init();
+        runtime_jobs = init (runtime_jobs);
 
         for (const auto& file : sorted_files )
           {
@@ -1130,39 +1434,88 @@ namespace coder_compiler
           {
             std::set<coder_file_ptr> new_dll;
 
+            std::map<coder_file_ptr, std::vector<size_t>> forward_link_jobs;
+
             for (const auto& file : sorted_files )
               {
                 bool iscyclic = cycles.count(file);
 
                 if (iscyclic)
                   {
+                    auto& fjobs = forward_link_jobs[file];
+
                     for (const auto& c_file: cycles.at(file))
                       {
-                        bool b = forward_link (c_file);
+                        auto fjob = forward_link (c_file);
 
-                        if (b)
-                          new_dll.insert (file);
+                        if (! fjob.empty ())
+                          {
+                            new_dll.insert (c_file);
+
+                            fjobs.insert (fjobs.end (), fjob.begin (), fjob.end ());
+                          }
                       }
                   }
               }
 
+            // a library is linked after the libraries of its callees. Members
+            // of a connected component are linked after the forward link of
+            // the component.
+
+            std::map<coder_file_ptr, std::vector<size_t>> link_jobs;
+
             for (const auto& file : sorted_files )
               {
+                std::vector<size_t> deps = runtime_jobs;
+
+                if (merged.count (file))
+                  for (const auto& callee : merged.at (file))
+                    {
+                      auto it = link_jobs.find (callee);
+
+                      if (it != link_jobs.end ())
+                        deps.insert (deps.end (), it->second.begin (), it->second.end ());
+                    }
+
+                auto& ljobs = link_jobs[file];
+
                 bool iscyclic = cycles.count(file);
 
                 if (iscyclic)
                   {
+                    const auto& fjobs = forward_link_jobs[file];
+
+                    deps.insert (deps.end (), fjobs.begin (), fjobs.end ());
+
+                    // the members link against each other so they are linked
+                    // one after another, otherwise a member could read a
+                    // library that another member is writing
+
                     for (const auto& c_file: cycles.at(file))
                       {
-                        link (c_file, new_dll.count (c_file));
+                        auto ljob = link (c_file, new_dll.count (c_file), deps);
+
+                        deps.insert (deps.end (), ljob.begin (), ljob.end ());
+
+                        ljobs.insert (ljobs.end (), ljob.begin (), ljob.end ());
                       }
                   }
                 else
                   {
-                    link (file, new_dll.count (file));
+                    ljobs = link (file, new_dll.count (file), deps);
                   }
               }
           }
+
+      }
+
+    scheduler.run ();
+
+    for (const auto& stamp : object_hashes)
+      {
+        std::ofstream os (stamp.first, std::ios::out | std::ios::binary);
+
+        os << stamp.second;
       }
 
     if (mkoct_bridge)
@@ -51,7 +51,9 @@ namespace coder_compiler
       bool debug,
       bool keepcc,
       bool verbose,
-      const std::string& compiler_options
+      const std::string& compiler_options,
+      int jobs,
+      bool profile
     );
 
     void
@@ -65,7 +67,9 @@ namespace coder_compiler
       bool debug,
       bool keepcc,
       bool verbose,
-      const std::string& compiler_options
+      const std::string& compiler_options,
+      int jobs,
+      bool profile
     );
 
     void
@@ -1,4 +1,5 @@
 #include  <bitset>
+#include  <cmath>
 #include  <memory>
 
 #include <octave/defaults.h>
@@ -272,14 +273,25 @@ namespace coder_compiler
     dependency_graph(dependency_graph),
     traversed_scopes (m_file->traverse()),
     loop_or_unwind (),
+    unwind_ids (),
+    nunwind (0),
     nconst(0),
     constant_map(),
+    nmethods (0),
+    switch_case (-1),
     os_hdr_ext(header),
     os_src_ext(source),
     os_prt_ext(partial_source),
     mode(mode),
     nesting_context(0),
-    nested_fcn_names()
+    nested_fcn_names(),
+    callees (),
+    folder (),
+    profile_name (),
+    parfor_enabled (false),
+    parfor_body (false),
+    parfor_unlocked (false),
+    boxed_loops (false)
   {
     loop_or_unwind.push_back (normal_context);
 
@@ -326,14 +338,62 @@ namespace coder_compiler
   void
   code_generator::visit_anon_fcn_handle (octave::tree_anon_fcn_handle& anon_fh)
   {
-    os_src
-      << "Anonymous (fcn2ov(["
-      << "="
-      << "](coder_value_list& output, const octave_value_list& args, int nargout) mutable\n{\n";
+    const auto anon_scope = traversed_scopes.front()[1].front();
+
+    // The lambda copies the variables of the enclosing function that the
+    // anonymous function refers to. Without them the lambda is a plain
+    // function and the runtime creates its handle once.
+
+    bool is_closure = ! anon_scope->free_symbols ().empty ();
+
+    // If all of the captured variables are Symbols and there are no more
+    // than max_captures of coder_capturing_function in the runtime, their
+    // copies are stored in the function object and passed to a plain
+    // function. Otherwise the lambda is wrapped in a std::function.
+
+    const std::size_t max_captures = 8;
+
+    std::vector<std::string> captures;
+
+    bool fixed_captures = is_closure;
+
+    if (is_closure)
+      for (const auto& sym : anon_scope->free_symbols ())
+        {
+          const std::string& name = sym->name;
+
+          if (callees.find (name) != callees.end ())
+            continue;
+
+          if (name == "nargin" || name == "nargout" || name == "isargout"
+              || name == "narginchk" || name == "nargoutchk"
+              || scalar_vars.find (name) != scalar_vars.end ()
+              || captures.size () == max_captures)
+            {
+              fixed_captures = false;
+
+              break;
+            }
+
+          captures.push_back (name);
+        }
+
+    if (fixed_captures)
+      os_src
+        << "Anonymous (fcn2ov([]"
+        << "(coder_value_list& output, const octave_value_list& args, int nargout, Symbol *captures) mutable\n{\n";
+    else
+      os_src
+        << (is_closure ? "Anonymous (fcn2ov([=]" : "Anonymous ([]")
+        << "(coder_value_list& output, const octave_value_list& args, int nargout) mutable\n{\n";
 
     increment_indent_level (os_src);
 
-    fcn_scopes.push_back (traversed_scopes.front()[1].front());
+    if (fixed_captures)
+      for (std::size_t i = 0; i < captures.size (); i++)
+        os_src << "Symbol& " << mangle (captures[i]) << " = captures[" << i << "];\n";
+
+    fcn_scopes.push_back (anon_scope);
 
     declare_and_define_handle_variables();
 
@@ -383,7 +443,17 @@ namespace coder_compiler
 
     decrement_indent_level (os_src);
 
-    os_src << "}))";
+    if (fixed_captures)
+      {
+        os_src << "}, {";
+
+        for (std::size_t i = 0; i < captures.size (); i++)
+          os_src << (i ? ", &" : "&") << mangle (captures[i]);
+
+        os_src << "}))";
+      }
+    else
+      os_src << (is_closure ? "}))" : "})");
 
     fcn_scopes.pop_back ();
   }
@@ -410,6 +480,9 @@ namespace coder_compiler
   void
   code_generator::visit_binary_expression (octave::tree_binary_expression& expr)
   {
+    if (boxed_scalar_expression (expr) || folded_constant (expr))
+      return;
+
     octave::tree_expression *op_lhs = expr.lhs ();
 
     octave::tree_expression *op_rhs = expr.rhs ();
@@ -512,6 +585,9 @@ namespace coder_compiler
   void
   code_generator::visit_boolean_expression (octave::tree_boolean_expression& expr)
   {
+    if (boxed_scalar_expression (expr))
+      return;
+
     octave_value val;
 
     octave::tree_expression *op_lhs = expr.lhs ();
@@ -552,6 +628,9 @@ namespace coder_compiler
   void
   code_generator::visit_compound_binary_expression (octave::tree_compound_binary_expression& expr)
   {
+    if (folded_constant (expr))
+      return;
+
     octave::tree_expression *op_lhs = expr.clhs ();
 
     octave::tree_expression *op_rhs = expr.crhs ();
@@ -612,12 +691,7 @@ namespace coder_compiler
   void
   code_generator::visit_break_command (octave::tree_break_command&)
   {
-    if (loop_or_unwind.back () == unwinding_context)
-      {
-        os_src << "throw break_unwind {};\n";
-      }
-    else
-      os_src << "break;\n";
+    exit_statement ("unwind_break");
   }
 
   void
@@ -671,12 +745,7 @@ namespace coder_compiler
   void
   code_generator::visit_continue_command (octave::tree_continue_command&)
   {
-    if (loop_or_unwind.back () == unwinding_context)
-      {
-        os_src << "throw continue_unwind {};\n";
-      }
-    else
-      os_src << "continue;\n";
+    exit_statement ("unwind_continue");
   }
 
   void
@@ -809,6 +878,20 @@ namespace coder_compiler
 
     octave::tree_statement_list *list = cmd.body ();
 
+    // parfor loops inside of the body of a parallel loop run serially
+
+    if (cmd.in_parallel () && parfor_enabled && ! parfor_body)
+      {
+        parfor_analyser analysis (cmd);
+
+        if (analysis.is_parallel ())
+          {
+            parallel_for_command (cmd, analysis);
+
+            return;
+          }
+      }
+
     int fast_loop = 1;
 
     if (list)
@@ -823,6 +906,177 @@ namespace coder_compiler
           }
       }
 
+    // The loop variable is a native double and the loop counter is a plain
+    // integer. The loop variable is boxed only where it is used as a value.
+    // If the bounds aren't known to be scalars they are checked at run time
+    // and if they aren't real double scalars the body is run with a boxed
+    // loop variable that shadows the native one.
+
+    if (lhs->is_identifier () && scalar_vars.count (lhs->name ()))
+      {
+        octave::tree_colon_expression *colon = static_cast<octave::tree_colon_expression *> (expr);
+
+        std::string name = lhs->name ();
+
+        bool checked = ! type_analyser::is_scalar_range (expr, scalar_vars);
+
+        os_src << "{\n";
+
+        increment_indent_level (os_src);
+
+        if (checked)
+          {
+            os_src << "const colon_range range (";
+
+            colon->base ()->accept (*this);
+
+            if (colon->increment ())
+              {
+                os_src << ", ";
+
+                colon->increment ()->accept (*this);
+              }
+
+            os_src << ", ";
+
+            colon->limit ()->accept (*this);
+
+            os_src << ");\n";
+          }
+        else
+          {
+            os_src << "const scalar_range range (";
+
+            scalar_expression (*colon->base ());
+
+            if (colon->increment ())
+              {
+                os_src << ", ";
+
+                scalar_expression (*colon->increment ());
+              }
+
+            os_src << ", ";
+
+            scalar_expression (*colon->limit ());
+
+            os_src << ");\n";
+          }
+
+        // the checked loops inside of a boxed body are only boxed so a body
+        // is generated at most twice
+
+        bool native = ! checked || ! boxed_loops;
+
+        profile_site ("for", cmd.line ());
+
+        if (native)
+          {
+            if (checked)
+              {
+                os_src << "if (range.is_scalar ())\n";
+
+                increment_indent_level (os_src);
+              }
+
+            os_src << "for (octave_idx_type k = 0; k < range.numel (); k++)\n";
+
+            loop_or_unwind.push_back(looping_context);
+
+            increment_indent_level (os_src);
+
+            os_src << "{\n";
+
+            increment_indent_level (os_src);
+
+            os_src << mangle (name) << " = range.elem (k);\n";
+
+            os_src << "PROFILE_ENTER\n";
+
+            if(list) list->accept(*this);
+
+            decrement_indent_level (os_src);
+
+            os_src
+              << "}\n";
+
+            decrement_indent_level (os_src);
+
+            loop_or_unwind.pop_back();
+
+            if (checked)
+              decrement_indent_level (os_src);
+          }
+
+        if (checked)
+          {
+            if (native)
+              {
+                os_src << "else\n";
+
+                increment_indent_level (os_src);
+
+                os_src << "{\n";
+
+                increment_indent_level (os_src);
+              }
+
+            os_src
+              << "Symbol " << mangle (name) << ";\n"
+              << "for (auto i : for_loop (" << mangle (name) << ", range, "
+              << fast_loop
+              << "))\n";
+
+            loop_or_unwind.push_back(looping_context);
+
+            increment_indent_level (os_src);
+
+            os_src << "{\n";
+
+            increment_indent_level (os_src);
+
+            os_src << "PROFILE_ENTER\n";
+
+            scalar_map outer_scalar_vars = scalar_vars;
+
+            scalar_vars.erase (name);
+
+            bool outer_boxed_loops = boxed_loops;
+
+            boxed_loops = true;
+
+            if(list) list->accept(*this);
+
+            boxed_loops = outer_boxed_loops;
+
+            scalar_vars.swap (outer_scalar_vars);
+
+            decrement_indent_level (os_src);
+
+            os_src
+              << "}\n";
+
+            decrement_indent_level (os_src);
+
+            loop_or_unwind.pop_back();
+
+            if (native)
+              {
+                decrement_indent_level (os_src);
+
+                os_src << "}\n";
+
+                decrement_indent_level (os_src);
+              }
+          }
+
+        decrement_indent_level (os_src);
+
+        os_src << "}\n";
+
+        return;
+      }
+
     os_src
       << "for (auto i : for_loop (" ;
 
@@ -845,6 +1099,8 @@ namespace coder_compiler
 
     increment_indent_level (os_src);
 
+    profile_scope ("for", cmd.line ());
+
     if(list) list->accept(*this);
 
     decrement_indent_level (os_src);
@@ -857,6 +1113,324 @@ namespace coder_compiler
     loop_or_unwind.pop_back();
   }
 
+  // Runs the chunks of the iterations of a parfor loop on the worker
+  // threads. Each chunk has its own copy of the loop variable, the
+  // temporaries and the reduction variables. The statements of the body that
+  // aren't native C++ code hold the interpreter lock.
+
+  void
+  code_generator::parallel_for_command (octave::tree_simple_for_command& cmd, const parfor_analyser& analysis)
+  {
+    octave::tree_expression *lhs = cmd.left_hand_side ();
+
+    octave::tree_expression *expr = cmd.control_expr ();
+
+    octave::tree_expression *maxproc = cmd.maxproc_expr ();
+
+    octave::tree_statement_list *list = cmd.body ();
+
+    std::string loop_var = lhs->name ();
+
+    bool native_loop = scalar_vars.count (loop_var)
+                       && type_analyser::is_scalar_range (expr, scalar_vars);
+
+    const auto& reductions = analysis.reductions ();
+
+    std::set<std::string> privates = analysis.temporaries ();
+
+    privates.insert (loop_var);
+
+    for (const auto& red : reductions)
+      privates.insert (red.first);
+
+    os_src << "{\n";
+
+    increment_indent_level (os_src);
+
+    if (native_loop)
+      {
+        octave::tree_colon_expression *colon = static_cast<octave::tree_colon_expression *> (expr);
+
+        os_src << "const scalar_range range (";
+
+        scalar_expression (*colon->base ());
+
+        if (colon->increment ())
+          {
+            os_src << ", ";
+
+            scalar_expression (*colon->increment ());
+          }
+
+        os_src << ", ";
+
+        scalar_expression (*colon->limit ());
+
+        os_src
+          << ");\n"
+          << "parfor_loop loop (range.numel ()";
+      }
+    else
+      {
+        os_src << "parfor_loop loop (";
+
+        expr->accept (*this);
+      }
+
+    if (maxproc)
+      {
+        os_src << ", ";
+
+        maxproc->accept (*this);
+      }
+
+    os_src << ");\n";
+
+    for (const auto& red : reductions)
+      {
+        std::string name = mangle (red.first);
+
+        if (scalar_vars.count (red.first))
+          os_src << "std::vector<double> " << name << "parts (loop.chunks ());\n";
+        else
+          os_src << "std::vector<Symbol> " << name << "parts (loop.chunks ());\n";
+      }
+
+    // the variables that keep the value of the last iteration
+
+    for (const std::string& var : privates)
+      if (! reductions.count (var))
+        os_src << "auto& " << mangle (var) << "last = " << mangle (var) << ";\n";
+
+    os_src << "loop.run ([&] (const parfor_chunk& chunk)\n";
+
+    increment_indent_level (os_src);
+
+    os_src << "{\n";
+
+    increment_indent_level (os_src);
+
+    os_src << "interpreter_lock lock;\n";
+
+    for (const std::string& var : privates)
+      {
+        std::string name = mangle (var);
+
+        auto sc = scalar_vars.find (var);
+
+        auto red = reductions.find (var);
+
+        if (sc != scalar_vars.end ())
+          {
+            std::string init = sc->second == st_double ? "0" : "false";
+
+            if (red != reductions.end ())
+              {
+                octave_value::binary_op op = red->second.op;
+
+                if (op == octave_value::op_mul || op == octave_value::op_el_mul)
+                  init = "1";
+                else if (op == octave_value::op_el_and)
+                  init = "true";
+              }
+
+            os_src
+              << (sc->second == st_double ? "double " : "bool ")
+              << name << " = " << init << ";\n";
+          }
+        else
+          {
+            os_src << "Symbol " << name << ";\n";
+
+            if (red != reductions.end ())
+              {
+                octave_value::binary_op op = red->second.op;
+
+                os_src << "Assign (" << name << ", ";
+
+                if (op == octave_value::op_add)
+                  os_src << "double_literal (0)";
+                else if (op == octave_value::op_el_and)
+                  os_src << "bool_literal (true)";
+                else if (op == octave_value::op_el_or)
+                  os_src << "bool_literal (false)";
+                else
+                  os_src << "double_literal (1)";
+
+                os_src << ").evaluate ();\n";
+              }
+          }
+      }
+
+    os_src
+      << "lock.unlock ();\n"
+      << "try\n";
+
+    increment_indent_level (os_src);
+
+    os_src << "{\n";
+
+    increment_indent_level (os_src);
+
+    os_src << "for (octave_idx_type k = chunk.first (); k < chunk.last (); k++)\n";
+
+    increment_indent_level (os_src);
+
+    os_src << "{\n";
+
+    increment_indent_level (os_src);
+
+    if (native_loop)
+      os_src << mangle (loop_var) << " = range.elem (k);\n";
+    else
+      os_src << "chunk.set_loop_val (" << mangle (loop_var) << ", k);\n";
+
+    loop_or_unwind.push_back(looping_context);
+
+    parfor_body = true;
+
+    parfor_unlocked = true;
+
+    if (list)
+      list->accept (*this);
+
+    parfor_unlocked = false;
+
+    parfor_body = false;
+
+    loop_or_unwind.pop_back();
+
+    decrement_indent_level (os_src);
+
+    os_src << "}\n";
+
+    decrement_indent_level (os_src);
+
+    decrement_indent_level (os_src);
+
+    os_src << "}\n";
+
+    decrement_indent_level (os_src);
+
+    os_src << "catch (...)\n";
+
+    increment_indent_level (os_src);
+
+    os_src << "{\n";
+
+    increment_indent_level (os_src);
+
+    os_src
+      << "lock.lock ();\n"
+      << "throw;\n";
+
+    decrement_indent_level (os_src);
+
+    os_src << "}\n";
+
+    decrement_indent_level (os_src);
+
+    os_src << "lock.lock ();\n";
+
+    for (const auto& red : reductions)
+      {
+        std::string name = mangle (red.first);
+
+        if (scalar_vars.count (red.first))
+          os_src << name << "parts[chunk.index ()] = " << name << ";\n";
+        else
+          os_src << "Assign (" << name << "parts[chunk.index ()], " << name << ").evaluate ();\n";
+      }
+
+    os_src << "if (chunk.is_last ())\n";
+
+    increment_indent_level (os_src);
+
+    os_src << "{\n";
+
+    increment_indent_level (os_src);
+
+    for (const std::string& var : privates)
+      {
+        if (reductions.count (var))
+          continue;
+
+        std::string name = mangle (var);
+
+        if (scalar_vars.count (var))
+          os_src << name << "last = " << name << ";\n";
+        else
+          os_src << "Assign (" << name << "last, " << name << ").evaluate ();\n";
+      }
+
+    decrement_indent_level (os_src);
+
+    os_src << "}\n";
+
+    decrement_indent_level (os_src);
+
+    decrement_indent_level (os_src);
+
+    os_src << "});\n";
+
+    decrement_indent_level (os_src);
+
+    // combine the partial results in the order of the iterations. Each
+    // chunk reduces its own iterations starting from the identity of the
+    // operator so the result may differ from the serial loop by rounding,
+    // but it doesn't depend on the number of threads.
+
+    static const std::map<octave_value::binary_op, std::pair<std::string, std::string>> operators ({
+      {octave_value::op_add, {" + ", "Plus"}},
+      {octave_value::op_mul, {" * ", "Mtimes"}},
+      {octave_value::op_el_mul, {" * ", "Times"}},
+      {octave_value::op_el_and, {" && ", "And"}},
+      {octave_value::op_el_or, {" || ", "Or"}}
+    });
+
+    for (const auto& red : reductions)
+      {
+        std::string name = mangle (red.first);
+
+        const auto& op = operators.at (red.second.op);
+
+        bool left = red.second.left;
+
+        if (scalar_vars.count (red.first))
+          {
+            os_src << "for (double part : " << name << "parts)\n";
+
+            increment_indent_level (os_src);
+
+            os_src
+              << name << " = ("
+              << (left ? name : "part")
+              << op.first
+              << (left ? "part" : name)
+              << ");\n";
+          }
+        else
+          {
+            os_src << "for (Symbol& part : " << name << "parts)\n";
+
+            increment_indent_level (os_src);
+
+            os_src
+              << "Assign (" << name << ", " << op.second << " ("
+              << (left ? name : "part")
+              << ", "
+              << (left ? "part" : name)
+              << ")).evaluate ();\n";
+          }
+
+        decrement_indent_level (os_src);
+      }
+
+    decrement_indent_level (os_src);
+
+    os_src << "}\n";
+  }
+
   void
   code_generator::visit_complex_for_command (octave::tree_complex_for_command& cmd)
   {
@@ -898,6 +1472,8 @@ namespace coder_compiler
 
     increment_indent_level (os_src);
 
+    profile_scope ("for", cmd.line ());
+
     if(list) list->accept(*this);
 
     decrement_indent_level (os_src);
@@ -950,8 +1526,28 @@ namespace coder_compiler
   {
     fcn_scopes.push_back (traversed_scopes.front()[0].front());
 
+    scalar_map outer_scalar_vars;
+
+    outer_scalar_vars.swap (scalar_vars);
+
+    bool outer_parfor_enabled = parfor_enabled;
+
+    // variables of nested functions are shared so they remain Symbols and
+    // parfor loops run serially
+
+    parfor_enabled = ! fcn.is_nested_function () && ! has_nested_function (fcn);
+
+    if (parfor_enabled)
+      scalar_vars = type_analyser (fcn).scalar_variables ();
+
     visit_octave_user_function_header (fcn);
 
+    std::string outer_profile_name = profile_name;
+
+    profile_name = fcn.name () == m_file->name ? fcn.name () : m_file->name + ">" + fcn.name ();
+
+    profile_scope ("", 0);
+
     octave::tree_statement_list *cmd_list = fcn.body ();
 
     if (cmd_list)
@@ -959,8 +1555,14 @@ namespace coder_compiler
         cmd_list->accept (*this);
       }
 
+    profile_name = outer_profile_name;
+
     visit_octave_user_function_trailer (fcn);
 
+    scalar_vars.swap (outer_scalar_vars);
+
+    parfor_enabled = outer_parfor_enabled;
+
     fcn_scopes.pop_back ();
   }
 
@@ -1000,7 +1602,7 @@ namespace coder_compiler
 
 				declare_persistent_variables();
 
-				declare_and_define_variables();
+				declare_and_define_variables(fcn);
 
 				std::string pers =  init_persistent_variables();
 
@@ -1245,6 +1847,9 @@ namespace coder_compiler
 
     const std::string & name = id.name ();
 
+    if (boxed_scalar_expression (id))
+      return;
+
     auto f = special_functions.find(name);
 
     if (f != special_functions.end())
@@ -1256,7 +1861,14 @@ namespace coder_compiler
     else if (name == "~")
       os_src << "Tilde()";
     else
-      os_src << mangle(id.name ());
+      {
+        auto c = callees.find (name);
+
+        if (c != callees.end ())
+          os_src << "Callee (" << c->second << ")";
+        else
+          os_src << mangle(id.name ());
+      }
   }
 
   void
@@ -1268,7 +1880,7 @@ namespace coder_compiler
       {
         os_src << "(";
 
-        expr->accept (*this);
+        visit_condition (*expr);
 
         os_src << ")";
       }
@@ -1402,35 +2014,107 @@ namespace coder_compiler
                       {
                         os_src << "Const(" << nconst << ")";
 
-                        constant_map[text_rep] = nconst++;
-                      }
-                    else
-                      os_src << "Const(" << f->second << ")";
-                  }
-              }
-          }
-        else if (elt)
-          elt->accept (*this);
+                        constant_map[text_rep] = nconst++;
+                      }
+                    else
+                      os_src << "Const(" << f->second << ")";
+                  }
+              }
+          }
+        else if (elt)
+          elt->accept (*this);
+
+        os_src
+          << "}";
+
+        if (i+1 < n)
+          os_src  << ", ";
+
+        p_arg_names++;
+
+        p_dyn_field++;
+      }
+
+    os_src  << "}";
+
+    // a call that may dispatch to a class method caches the methods
+
+    if (e && e->is_identifier() && type_tags[0] == '(')
+      os_src << ", Methods(" << nmethods++ << ")";
+
+    os_src  << ")" ;
+  }
+
+  // Emits a matrix whose elements are all native scalars, at least one of
+  // them a double, and whose rows have the same non-zero length as a
+  // ScalarMatrix.
+
+  bool
+  code_generator::scalar_matrix (octave::tree_matrix& lst)
+  {
+    std::size_t rows = 0;
+
+    int cols = 0;
+
+    bool has_double = false;
+
+    for (octave::tree_argument_list *row : lst)
+      {
+        if (! row || row->empty () || (rows > 0 && row->length () != cols))
+          return false;
+
+        for (octave::tree_expression *elem : *row)
+          {
+            scalar_type type = type_analyser::expression_type (elem, scalar_vars);
+
+            if (type == st_unknown)
+              return false;
+
+            has_double = has_double || type == st_double;
+          }
+
+        cols = row->length ();
+
+        rows++;
+      }
+
+    if (rows == 0 || ! has_double)
+      return false;
+
+    os_src << "ScalarMatrix(" << rows << ", " << cols << ", {";
+
+    bool first = true;
+
+    for (octave::tree_argument_list *row : lst)
+      for (octave::tree_expression *elem : *row)
+        {
+          if (! first)
+            os_src << ", ";
+
+          first = false;
 
-        os_src
-          << "}";
+          bool cast = type_analyser::expression_type (elem, scalar_vars) == st_bool;
 
-        if (i+1 < n)
-          os_src  << ", ";
+          if (cast)
+            os_src << "double (";
 
-        p_arg_names++;
+          scalar_expression (*elem);
 
-        p_dyn_field++;
-      }
+          if (cast)
+            os_src << ")";
+        }
 
-    os_src  << "}";
+    os_src << "})";
 
-    os_src  << ")" ;
+    return true;
   }
 
   void
   code_generator::visit_matrix (octave::tree_matrix& lst)
   {
+    if (folded_constant (lst) || scalar_matrix (lst))
+      return;
+
     os_src << "Matrixc({";
 
     octave::tree_matrix::iterator p = lst.begin ();
@@ -1789,6 +2473,101 @@ namespace coder_compiler
       os_src << "Const(" << f->second << ")";
   }
 
+  // The code of a value of a folded constant expression or an empty string
+  // if the value has no exact representation
+
+  static std::string
+  folded_value_code (const octave_value& val)
+  {
+    std::ostringstream os;
+
+    os.precision (17);
+
+    auto number = [&](double d)
+    {
+      if (d == 0 && std::signbit (d))
+        os << "-0.0";
+      else
+        os << d;
+    };
+
+    if (val.is_bool_scalar ())
+      {
+        os << "bool_literal (" << (val.bool_value () ? "true" : "false") << ")";
+      }
+    else if (val.is_double_type () && val.isreal () && ! val.issparse ()
+             && ! val.is_range () && val.ndims () == 2
+             && (val.is_real_scalar () || val.is_real_matrix ()))
+      {
+        ::Matrix m = val.matrix_value ();
+
+        for (octave_idx_type i = 0; i < m.numel (); i++)
+          if (! std::isfinite (m(i)))
+            return "";
+
+        if (m.numel () == 1)
+          {
+            os << "double_literal (";
+
+            number (m(0));
+
+            os << ")";
+          }
+        else
+          {
+            os << "ScalarMatrix(" << m.rows () << ", " << m.columns () << ", {";
+
+            for (octave_idx_type i = 0; i < m.rows (); i++)
+              for (octave_idx_type j = 0; j < m.columns (); j++)
+                {
+                  if (i > 0 || j > 0)
+                    os << ", ";
+
+                  number (m(i, j));
+                }
+
+            os << "})";
+          }
+      }
+    else if (val.is_string () && val.rows () == 1 && val.columns () > 0
+             && val.string_value ().find ('\0') == std::string::npos)
+      {
+        print_value (os, val);
+      }
+
+    return os.str ();
+  }
+
+  // Emits a constant expression that is evaluated at translation time as an
+  // element of the constant table
+
+  bool
+  code_generator::folded_constant (octave::tree_expression& expr)
+  {
+    octave_value val;
+
+    if (! folder.fold (&expr, val))
+      return false;
+
+    std::string text_rep = folded_value_code (val);
+
+    if (text_rep.empty ())
+      return false;
+
+    auto f = constant_map.find(text_rep);
+
+    if(f == constant_map.end())
+      {
+        os_src << "Const(" << nconst << ")";
+
+        constant_map[text_rep] = nconst++;
+      }
+    else
+      os_src << "Const(" << f->second << ")";
+
+    return true;
+  }
+
   bool
   code_generator::visit_dot_separated_fcn_handle (octave::tree_fcn_handle& expr)
   {
@@ -1820,7 +2599,12 @@ namespace coder_compiler
           }
         os_src  << "Index (";
 
-        os_src << mangle(id_name);
+        auto c = callees.find (id_name);
+
+        if (c != callees.end ())
+          os_src << "Callee (" << c->second << ")";
+        else
+          os_src << mangle(id_name);
 
         os_src << ", \"" << type_tags << "\"";
 
@@ -1962,6 +2746,9 @@ namespace coder_compiler
   void
   code_generator::visit_postfix_expression (octave::tree_postfix_expression& expr)
   {
+    if (boxed_scalar_expression (expr) || folded_constant (expr))
+      return;
+
     octave::tree_expression *op = expr.operand ();
 
     auto do_post = [&](const std::string& fcn, octave_value::unary_op parent_op)
@@ -2009,6 +2796,9 @@ namespace coder_compiler
   void
   code_generator::visit_prefix_expression (octave::tree_prefix_expression& expr)
   {
+    if (boxed_scalar_expression (expr) || folded_constant (expr))
+      return;
+
     octave::tree_expression *op = expr.operand ();
 
     auto do_pre = [&](const std::string& fcn, octave_value::unary_op parent_op)
@@ -2058,15 +2848,33 @@ namespace coder_compiler
   void
   code_generator::visit_return_command (octave::tree_return_command&)
   {
-    for (auto lu : loop_or_unwind)
-      if (lu == unwinding_context)
-        {
-          os_src << "throw return_unwind {};\n";
+    exit_statement ("unwind_return");
+  }
 
-          return;
-        }
+  void
+  code_generator::exit_statement (const std::string& status)
+  {
+    // break and continue leave the innermost unwind_protect block only if
+    // it is inside of the innermost loop.
 
-    os_src << "goto Return;\n";
+    bool is_return = status == "unwind_return";
+
+    if (! unwind_ids.empty ()
+        && (is_return || loop_or_unwind.back () == unwinding_context))
+      {
+        os_src
+          << "UNWIND_EXIT ("
+          << unwind_ids.back ()
+          << ", "
+          << status
+          << ")\n";
+      }
+    else if (is_return)
+      os_src << "goto Return;\n";
+    else if (status == "unwind_break")
+      os_src << "break;\n";
+    else
+      os_src << "continue;\n";
   }
 
   void
@@ -2183,63 +2991,343 @@ namespace coder_compiler
                                               {
                                                 bool ismatch = false;
 
-                                                char first = chm(0);
+                                                char first = chm(0);
+
+                                                for(char c: R"(.+-*/\^&|<>=:)")
+                                                  {
+                                                    if(first == c)
+                                                      {
+                                                        ismatch = true;
+
+                                                        break;
+                                                      }
+                                                  }
+                                                if(! ismatch)
+                                                  return "";
+                                              }
+
+                                            retval += cnst->value().string_value() + " ";
+                                          }
+                                        else
+                                          return "";
+                                      }
+                                    else
+                                      return "";
+                                  }
+                                else
+                                  return "";
+                                i++;
+                              }
+                          }
+                        else
+                          return "";
+                      }
+                    else
+                      return "";
+                  }
+                else
+                  return "";
+
+                octave::tree_identifier* id = dynamic_cast<octave::tree_identifier*>(e);
+
+                if(id)
+                  retval = id->name() + " " + retval + ";";
+              }
+            else
+              return "";
+          }
+        else
+          return "";
+      }
+    else
+      return "";
+
+    return retval;
+  }
+
+  // Emits an expression that type_analyser has proven to be a real double
+  // scalar or a logical scalar as a native C++ expression.
+
+  void
+  code_generator::scalar_expression (octave::tree_expression& expr)
+  {
+    auto operand = [&](octave::tree_expression *op, bool to_double)
+    {
+      bool cast = to_double && type_analyser::expression_type (op, scalar_vars) == st_bool;
+
+      if (cast)
+        os_src << "double (";
+
+      scalar_expression (*op);
+
+      if (cast)
+        os_src << ")";
+    };
+
+    if (expr.is_identifier ())
+      {
+        os_src << mangle (expr.name ());
+      }
+    else if (expr.is_constant ())
+      {
+        octave_value val = static_cast<octave::tree_constant&> (expr).value ();
+
+        if (val.is_bool_scalar ())
+          os_src << (val.bool_value () ? "true" : "false");
+        else
+          {
+            std::ostringstream os;
+
+            os << std::setprecision (17) << val.double_value ();
+
+            std::string text = os.str ();
+
+            if (text.find_first_of (".e") == std::string::npos)
+              text += ".0";
+
+            os_src << "(" << text << ")";
+          }
+      }
+    else if (dynamic_cast<octave::tree_boolean_expression *> (&expr))
+      {
+        auto& bexpr = static_cast<octave::tree_boolean_expression&> (expr);
+
+        os_src << "(";
+
+        operand (bexpr.lhs (), false);
+
+        if (bexpr.op_type () == octave::tree_boolean_expression::bool_and)
+          os_src << " && ";
+        else
+          os_src << " || ";
+
+        operand (bexpr.rhs (), false);
+
+        os_src << ")";
+      }
+    else if (dynamic_cast<octave::tree_binary_expression *> (&expr))
+      {
+        auto& bexpr = static_cast<octave::tree_binary_expression&> (expr);
+
+        octave::tree_expression *lhs = bexpr.lhs ();
+
+        octave::tree_expression *rhs = bexpr.rhs ();
+
+        std::string op;
+
+        bool arithmetic = true;
+
+        switch (bexpr.op_type ())
+          {
+          case octave_value::op_add:    op = " + "; break;
+          case octave_value::op_sub:    op = " - "; break;
+          case octave_value::op_mul:
+          case octave_value::op_el_mul: op = " * "; break;
+          case octave_value::op_div:
+          case octave_value::op_el_div: op = " / "; break;
+          case octave_value::op_ldiv:
+          case octave_value::op_el_ldiv:
+            op = " / ";
+            std::swap (lhs, rhs);
+            break;
+          default:
+            arithmetic = false;
+            break;
+          }
+
+        if (! arithmetic)
+          switch (bexpr.op_type ())
+            {
+            case octave_value::op_lt:     op = " < "; break;
+            case octave_value::op_le:     op = " <= "; break;
+            case octave_value::op_eq:     op = " == "; break;
+            case octave_value::op_ge:     op = " >= "; break;
+            case octave_value::op_gt:     op = " > "; break;
+            case octave_value::op_ne:     op = " != "; break;
+            case octave_value::op_el_and: op = " && "; break;
+            case octave_value::op_el_or:  op = " || "; break;
+            default:
+              panic_impossible ();
+            }
+
+        os_src << "(";
+
+        operand (lhs, arithmetic);
+
+        os_src << op;
+
+        operand (rhs, arithmetic);
+
+        os_src << ")";
+      }
+    else if (dynamic_cast<octave::tree_prefix_expression *> (&expr))
+      {
+        auto& pexpr = static_cast<octave::tree_prefix_expression&> (expr);
+
+        switch (pexpr.op_type ())
+          {
+          case octave_value::op_uminus:
+            os_src << "(-";
+            operand (pexpr.operand (), true);
+            os_src << ")";
+            break;
+          case octave_value::op_uplus:
+            operand (pexpr.operand (), true);
+            break;
+          case octave_value::op_not:
+            os_src << "(!";
+            operand (pexpr.operand (), false);
+            os_src << ")";
+            break;
+          default:
+            panic_impossible ();
+          }
+      }
+    else if (dynamic_cast<octave::tree_postfix_expression *> (&expr))
+      {
+        // transpose of a scalar
+
+        operand (static_cast<octave::tree_postfix_expression&> (expr).operand (), false);
+      }
+    else
+      panic_impossible ();
+  }
+
+  // Converts a scalar expression to a value where an Expression is expected.
+
+  bool
+  code_generator::boxed_scalar_expression (octave::tree_expression& expr)
+  {
+    scalar_type type = type_analyser::expression_type (&expr, scalar_vars);
+
+    if (type == st_unknown)
+      return false;
+
+    if (type == st_double)
+      os_src << "double_literal (";
+    else
+      os_src << "bool_literal (";
+
+    scalar_expression (expr);
+
+    os_src << ")";
+
+    return true;
+  }
+
+  void
+  code_generator::visit_condition (octave::tree_expression& expr)
+  {
+    if (type_analyser::expression_type (&expr, scalar_vars) == st_bool)
+      scalar_expression (expr);
+    else
+      expr.accept (*this);
+  }
+
+  // Whether the statement is plain C++ code that doesn't use Octave values
+
+  bool
+  code_generator::native_statement (octave::tree_statement& stmt)
+  {
+    octave::tree_command *cmd = stmt.command ();
+
+    if (! cmd)
+      {
+        octave::tree_simple_assignment *asgn = dynamic_cast<octave::tree_simple_assignment *> (stmt.expression ());
+
+        return asgn && asgn->left_hand_side ()
+               && asgn->left_hand_side ()->is_identifier ()
+               && scalar_vars.count (asgn->left_hand_side ()->name ());
+      }
+
+    if (dynamic_cast<octave::tree_no_op_command *> (cmd)
+        || dynamic_cast<octave::tree_break_command *> (cmd)
+        || dynamic_cast<octave::tree_continue_command *> (cmd))
+      return true;
+
+    octave::tree_if_command *if_cmd = dynamic_cast<octave::tree_if_command *> (cmd);
+
+    if (if_cmd)
+      {
+        octave::tree_if_command_list *lst = if_cmd->cmd_list ();
+
+        if (! lst)
+          return true;
+
+        for (octave::tree_if_clause *elt : *lst)
+          {
+            if (! elt)
+              continue;
+
+            octave::tree_expression *cond = elt->condition ();
+
+            if (cond && type_analyser::expression_type (cond, scalar_vars) != st_bool)
+              return false;
+
+            if (! native_statement_list (elt->commands ()))
+              return false;
+          }
+
+        return true;
+      }
 
-                                                for(char c: R"(.+-*/\^&|<>=:)")
-                                                  {
-                                                    if(first == c)
-                                                      {
-                                                        ismatch = true;
+    octave::tree_while_command *while_cmd = dynamic_cast<octave::tree_while_command *> (cmd);
 
-                                                        break;
-                                                      }
-                                                  }
-                                                if(! ismatch)
-                                                  return "";
-                                              }
+    if (while_cmd)
+      return type_analyser::expression_type (while_cmd->condition (), scalar_vars) == st_bool
+             && native_statement_list (while_cmd->body ());
 
-                                            retval += cnst->value().string_value() + " ";
-                                          }
-                                        else
-                                          return "";
-                                      }
-                                    else
-                                      return "";
-                                  }
-                                else
-                                  return "";
-                                i++;
-                              }
-                          }
-                        else
-                          return "";
-                      }
-                    else
-                      return "";
-                  }
-                else
-                  return "";
+    octave::tree_simple_for_command *for_cmd = dynamic_cast<octave::tree_simple_for_command *> (cmd);
 
-                octave::tree_identifier* id = dynamic_cast<octave::tree_identifier*>(e);
+    if (for_cmd)
+      {
+        octave::tree_expression *lhs = for_cmd->left_hand_side ();
 
-                if(id)
-                  retval = id->name() + " " + retval + ";";
-              }
-            else
-              return "";
-          }
-        else
-          return "";
+        return lhs && lhs->is_identifier () && scalar_vars.count (lhs->name ())
+               && type_analyser::is_scalar_range (for_cmd->control_expr (), scalar_vars)
+               && native_statement_list (for_cmd->body ());
       }
-    else
-      return "";
 
-    return retval;
+    return false;
+  }
+
+  bool
+  code_generator::native_statement_list (octave::tree_statement_list *lst)
+  {
+    if (! lst)
+      return true;
+
+    for (octave::tree_statement *elt : *lst)
+      if (elt && ! native_statement (*elt))
+        return false;
+
+    return true;
   }
 
   void
   code_generator::visit_statement (octave::tree_statement& stmt)
   {
+    if (parfor_unlocked && ! native_statement (stmt))
+      {
+        os_src << "{\n";
+
+        increment_indent_level (os_src);
+
+        os_src << "interpreter_lock lock;\n";
+
+        parfor_unlocked = false;
+
+        visit_statement (stmt);
+
+        parfor_unlocked = true;
+
+        decrement_indent_level (os_src);
+
+        os_src << "}\n";
+
+        return;
+      }
+
     octave::tree_command *cmd = stmt.command ();
 
     if (cmd)
@@ -2261,6 +3349,21 @@ namespace coder_compiler
                   eval_str.c_str ());
               }
 
+            octave::tree_simple_assignment *asgn = dynamic_cast<octave::tree_simple_assignment *> (expr);
+
+            if (asgn && asgn->left_hand_side ()
+                && asgn->left_hand_side ()->is_identifier ()
+                && scalar_vars.count (asgn->left_hand_side ()->name ()))
+              {
+                os_src << mangle (asgn->left_hand_side ()->name ()) << " = ";
+
+                scalar_expression (*asgn->right_hand_side ());
+
+                os_src << ";\n";
+
+                return;
+              }
+
             expr->accept (*this);
 
             os_src << ".evaluate();\n";
@@ -2283,6 +3386,8 @@ namespace coder_compiler
   {
     if (cs.is_default_case ())
       os_src << "else";
+    else if (switch_case >= 0)
+      os_src << "else if (Case(" << switch_case++ << ", ";
     else
       os_src << "else if (Case( ";
 
@@ -2336,6 +3441,143 @@ namespace coder_compiler
       }
   }
 
+  // Adds the value of a constant case label to the string or the integer
+  // labels of a switch table. Returns false if the value is neither a
+  // string nor an integer.
+
+  static bool
+  switch_label_value (const octave_value& val, int index,
+                      std::vector<std::pair<std::string, int>>& strings,
+                      std::vector<std::pair<double, int>>& numbers)
+  {
+    if (val.iscell ())
+      {
+        Cell cell = val.cell_value ();
+
+        for (octave_idx_type i = 0; i < cell.numel (); i++)
+          if (cell(i).iscell ()
+              || ! switch_label_value (cell(i), index, strings, numbers))
+            return false;
+
+        return true;
+      }
+
+    if (val.is_string ())
+      {
+        if (val.rows () != 1 || val.columns () < 1)
+          return false;
+
+        std::string str = val.string_value ();
+
+        if (str.find ('\0') != std::string::npos)
+          return false;
+
+        strings.emplace_back (str, index);
+
+        return true;
+      }
+
+    if (val.is_real_scalar () && val.is_double_type ())
+      {
+        double d = val.double_value ();
+
+        if (d != std::trunc (d) || std::abs (d) > 9007199254740992.0)
+          return false;
+
+        numbers.emplace_back (d, index);
+
+        return true;
+      }
+
+    return false;
+  }
+
+  static bool
+  switch_label (octave::tree_expression *label, int index,
+                std::vector<std::pair<std::string, int>>& strings,
+                std::vector<std::pair<double, int>>& numbers)
+  {
+    if (! label)
+      return false;
+
+    if (label->is_constant ())
+      return switch_label_value (static_cast<octave::tree_constant *> (label)->value (),
+                                 index, strings, numbers);
+
+    if (auto cell = dynamic_cast<octave::tree_cell *> (label))
+      {
+        for (octave::tree_argument_list *row : *cell)
+          {
+            if (! row)
+              continue;
+
+            for (octave::tree_expression *elt : *row)
+              if (! elt || dynamic_cast<octave::tree_cell *> (elt)
+                  || ! switch_label (elt, index, strings, numbers))
+                return false;
+          }
+
+        return true;
+      }
+
+    return false;
+  }
+
+  // Emits the hash table of a switch command whose case labels are all
+  // constant strings and integers
+
+  bool
+  code_generator::switch_table (octave::tree_switch_case_list& lst)
+  {
+    std::vector<std::pair<std::string, int>> strings;
+
+    std::vector<std::pair<double, int>> numbers;
+
+    int index = 0;
+
+    for (octave::tree_switch_case *cs : lst)
+      {
+        if (! cs || cs->is_default_case ())
+          continue;
+
+        if (! switch_label (cs->case_label (), index++, strings, numbers))
+          return false;
+      }
+
+    if (index == 0)
+      return false;
+
+    os_src << "static const switch_table Cases ({";
+
+    std::string sep = "";
+
+    for (const auto& str : strings)
+      {
+        os_src
+          << sep << "{\"" << undo_string_escapes1 (str.first) << "\", "
+          << str.first.length () << ", " << str.second << "}";
+
+        sep = ", ";
+      }
+
+    os_src << "}, {";
+
+    sep = "";
+
+    for (const auto& num : numbers)
+      {
+        os_src
+          << sep << "{" << static_cast<long long> (num.first) << ".0, "
+          << num.second << "}";
+
+        sep = ", ";
+      }
+
+    os_src << "});\n";
+
+    return true;
+  }
+
   void
   code_generator::visit_switch_command (octave::tree_switch_command& cmd)
   {
@@ -2343,6 +3585,12 @@ namespace coder_compiler
 
     increment_indent_level (os_src);
 
+    octave::tree_switch_case_list *list = cmd.case_list ();
+
+    int outer_switch_case = switch_case;
+
+    switch_case = list && switch_table (*list) ? 0 : -1;
+
     os_src << "auto Case = Switch (";
 
     octave::tree_expression *expr = cmd.switch_value ();
@@ -2352,15 +3600,18 @@ namespace coder_compiler
     else
       error ("missing value in switch command");
 
-    os_src << ");\n";
+    if (switch_case >= 0)
+      os_src << ", Cases";
 
-    octave::tree_switch_case_list *list = cmd.case_list ();
+    os_src << ");\n";
 
     if (list)
       {
         list->accept (*this);
       }
 
+    switch_case = outer_switch_case;
+
     decrement_indent_level (os_src);
 
     os_src << "}\n";
@@ -2420,26 +3671,19 @@ namespace coder_compiler
   code_generator::visit_unwind_protect_command (octave::tree_unwind_protect_command& cmd)
   {
     bool loopflag = false;
-    bool loop_propagates = loop_or_unwind.back () == unwinding_context;
-    bool return_propagates = false;
 
     for (auto lu : loop_or_unwind)
       if (lu == looping_context)
-        {
-          loopflag = true;
-        }
-      else if (lu == unwinding_context)
-        {
-          return_propagates = true;
-        }
+        loopflag = true;
 
-    if (loopflag)
-      os_src << "UNWIND_PROTECT_LOOP(" ;
-    else
-      os_src << "UNWIND_PROTECT(" ;
+    int id = nunwind++;
+
+    os_src << "UNWIND_PROTECT(" << id << ",";
 
     loop_or_unwind.push_back(unwinding_context);
 
+    unwind_ids.push_back (id);
+
     increment_indent_level (os_src);
 
     os_src << "\n{\n" ;
@@ -2463,17 +3707,49 @@ namespace coder_compiler
 
     loop_or_unwind.pop_back ();
 
+    unwind_ids.pop_back ();
+
     if (cleanup_code)
       cleanup_code->accept (*this);
 
     decrement_indent_level (os_src);
 
-    os_src << "}, " << return_propagates ;
+    os_src << "}\n,\n{\n";
+
+    increment_indent_level (os_src);
+
+    // Continue the early exit of the body in the enclosing context.
+
+    os_src << "if (unwind_status_" << id << " == unwind_return)\n";
+
+    increment_indent_level (os_src);
+
+    exit_statement ("unwind_return");
+
+    decrement_indent_level (os_src);
 
     if (loopflag)
-      os_src << ", " << loop_propagates;
+      {
+        os_src << "else if (unwind_status_" << id << " == unwind_break)\n";
 
-    os_src << ")\n";
+        increment_indent_level (os_src);
+
+        exit_statement ("unwind_break");
+
+        decrement_indent_level (os_src);
+
+        os_src << "else if (unwind_status_" << id << " == unwind_continue)\n";
+
+        increment_indent_level (os_src);
+
+        exit_statement ("unwind_continue");
+
+        decrement_indent_level (os_src);
+      }
+
+    decrement_indent_level (os_src);
+
+    os_src << "})\n";
 
     decrement_indent_level (os_src);
   }
@@ -2487,7 +3763,7 @@ namespace coder_compiler
     octave::tree_expression *expr = cmd.condition ();
 
     if (expr)
-      expr->accept (*this);
+      visit_condition (*expr);
 
     os_src
       << ",\n";
@@ -2502,6 +3778,8 @@ namespace coder_compiler
 
     loop_or_unwind.push_back(looping_context);
 
+    profile_scope ("while", cmd.line ());
+
     if (list)
       {
         list->accept (*this);
@@ -2531,6 +3809,8 @@ namespace coder_compiler
 
     increment_indent_level (os_src);
 
+    profile_scope ("do", cmd.line ());
+
     if (list)
       list->accept (*this);
 
@@ -2547,19 +3827,77 @@ namespace coder_compiler
     os_src << ", ";
 
     if (expr)
-      expr->accept (*this);
+      visit_condition (*expr);
 
     os_src << ")\n";
   }
 
+  // Emits the counters of the current function or of a loop body that are
+  // only compiled with the 'profile' option
+
+  void
+  code_generator::profile_scope (const std::string& kind, int line)
+  {
+    os_src << "PROFILE_SCOPE (\"" << undo_string_escapes1 (profile_name);
+
+    if (! kind.empty ())
+      os_src << ">" << kind << "@" << line;
+
+    os_src << "\")\n";
+  }
+
+  // Emits only the counters of a loop whose body is generated more than once.
+  // Each version of the body enters them with PROFILE_ENTER.
+
+  void
+  code_generator::profile_site (const std::string& kind, int line)
+  {
+    os_src << "PROFILE_SITE (\"" << undo_string_escapes1 (profile_name)
+           << ">" << kind << "@" << line << "\")\n";
+  }
+
   std::string
   code_generator::mangle (const std::string& str)
   {
     return str + "_";
   }
 
+  // A function that is never assigned in the body and isn't used by the
+  // nested functions or the anonymous functions is bound at its call sites
+  // so it isn't copied on each call.
+
+  bool
+  code_generator::is_callee (octave_user_function& fcn, const std::string& name)
+  {
+    const auto& scopes = traversed_scopes.front();
+
+    for (std::size_t i = 1; i < scopes[0].size (); i++)
+      if (scopes[0][i]->contains (name))
+        return false;
+
+    for (const auto& sc : scopes[1])
+      if (sc->contains (name))
+        return false;
+
+    octave::tree_statement_list *body = fcn.body ();
+
+    if (body)
+      {
+        try
+          {
+            lvalue_checker {m_file , body, name};
+          }
+        catch (int)
+          {
+            return false;
+          }
+      }
+
+    return true;
+  }
+
   void
-  code_generator::declare_and_define_variables()
+  code_generator::declare_and_define_variables(octave_user_function& fcn)
   {
     delimiter sep;
 
@@ -2567,6 +3905,16 @@ namespace coder_compiler
 
     auto scope_searcher = traversed_scopes.front()[0].front();
 
+    callees.clear ();
+
+    // builtin functions whose value is folded into constant expressions
+
+    static const std::set<std::string> constant_functions ({
+      "pi", "e", "Inf", "inf", "NaN", "nan", "NA", "eps", "true", "false"
+    });
+
+    std::set<std::string> folded_functions;
+
     static const std::map<std::string,std::string> special_functions ({
       {"nargin", "NARGIN"},
       {"nargout", "NARGOUT"},
@@ -2577,12 +3925,47 @@ namespace coder_compiler
 
     for(const auto& symbol : scope[(int)symbol_type::ordinary])
       {
+        if (constant_functions.count (symbol->name)
+            && symbol->fcn.is_builtin_function () && is_callee (fcn, symbol->name))
+          folded_functions.insert (symbol->name);
+
+        auto sc = scalar_vars.find(symbol->name);
+
+        if (sc != scalar_vars.end())
+          {
+            // nargin and nargout are initialized with the counts of the
+            // arguments
+
+            if (sc->second == st_double && symbol->name == "nargin")
+              os_src << "double " << mangle(symbol->name) << " = ovl_length (args);\n";
+            else if (sc->second == st_double && symbol->name == "nargout")
+              os_src << "double " << mangle(symbol->name) << " = nargout;\n";
+            else if (sc->second == st_double)
+              os_src << "double " << mangle(symbol->name) << " = 0;\n";
+            else
+              os_src << "bool " << mangle(symbol->name) << " = false;\n";
+
+            continue;
+          }
+
+        auto f = special_functions.find(symbol->name);
+
+        if (f == special_functions.end() && symbol->file
+            && symbol->fcn.is_defined () && is_callee (fcn, symbol->name))
+          {
+            callees[symbol->name] = mangle(symbol->file->name)
+              + std::to_string (symbol->file->id)
+              + "::"
+              + mangle(symbol->name)
+              + "make";
+
+            continue;
+          }
+
         os_src
           << "Symbol "
           << mangle(symbol->name) ;
 
-        auto f = special_functions.find(symbol->name);
-
         if (f != special_functions.end())
           {
             if (symbol->fcn.is_function())
@@ -2631,6 +4014,8 @@ namespace coder_compiler
         os_src << ";\n";
       }
 
+    folder.set_functions (folded_functions);
+
     static std::vector<std::string> special_names  =
     {
       "nargin",
@@ -2642,7 +4027,7 @@ namespace coder_compiler
 
     for (auto& name : special_names)
 			{
-			  if (scope_searcher->contains(name))
+			  if (scope_searcher->contains(name) && ! scalar_vars.count (name))
 				os_src
 					<< ([name]  () mutable {for (auto & c: name) c = toupper(c); return name;})()
 					<< "_MAKER;\n";
@@ -3090,7 +4475,9 @@ namespace coder_compiler
       {
         if (m_file->type == file_type::m || m_file->type == file_type::cmdline)
           {
-            os_src << "static Constant& Const(int);\n";
+            os_src
+              << "static Constant& Const(int);\n"
+              << "static method_cache& Methods(int);\n";
           }
 
         os_src
@@ -3261,6 +4648,18 @@ namespace coder_compiler
 
             decrement_indent_level (os_src);
 
+            os_src
+              << "}\n"
+              << "static method_cache& Methods(int i)\n{\n";
+
+            increment_indent_level (os_src);
+
+            os_src
+              << "static method_cache caches[" << std::max (nmethods, 1) << "];\n"
+              << "return caches[i];\n";
+
+            decrement_indent_level (os_src);
+
             os_src << "}\n";
           }
       }
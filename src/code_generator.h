@@ -17,6 +17,10 @@
 #include <octave/pt-walk.h>
 #include <octave/version.h>
 
+#include "constant_folder.h"
+#include "parfor_analyser.h"
+#include "type_analyser.h"
+
 class octave_user_function;
 
 class octave_value;
@@ -149,6 +153,9 @@ namespace coder_compiler
     void
     visit_simple_for_command (octave::tree_simple_for_command& cmd);
 
+    void
+    parallel_for_command (octave::tree_simple_for_command& cmd, const parfor_analyser& analysis);
+
     void
     visit_complex_for_command (octave::tree_complex_for_command& cmd);
 #if OCTAVE_MAJOR_VERSION >= 7
@@ -245,6 +252,9 @@ namespace coder_compiler
 
     void
     visit_return_command (octave::tree_return_command&);
+
+    void
+    exit_statement (const std::string& status);
 #if OCTAVE_MAJOR_VERSION < 6
     void
     visit_return_list (octave::tree_return_list& lst){}
@@ -255,6 +265,36 @@ namespace coder_compiler
     std::string
     ambiguity_check(octave::tree_expression &expr);
 
+    void
+    scalar_expression (octave::tree_expression& expr);
+
+    bool
+    boxed_scalar_expression (octave::tree_expression& expr);
+
+    bool
+    scalar_matrix (octave::tree_matrix& lst);
+
+    bool
+    folded_constant (octave::tree_expression& expr);
+
+    void
+    profile_scope (const std::string& kind, int line);
+
+    void
+    profile_site (const std::string& kind, int line);
+
+    bool
+    switch_table (octave::tree_switch_case_list& lst);
+
+    void
+    visit_condition (octave::tree_expression& expr);
+
+    bool
+    native_statement (octave::tree_statement& stmt);
+
+    bool
+    native_statement_list (octave::tree_statement_list *lst);
+
     void
     visit_statement (octave::tree_statement& stmt);
 
@@ -343,7 +383,10 @@ namespace coder_compiler
     mangle (const std::string& str);
 
     void
-    declare_and_define_variables();
+    declare_and_define_variables(octave_user_function& fcn);
+
+    bool
+    is_callee (octave_user_function& fcn, const std::string& name);
 
     void
     declare_and_define_nested_variables();
@@ -396,10 +439,18 @@ namespace coder_compiler
 
     std::vector<loop_or_unwind_state> loop_or_unwind;
 
+    std::vector<int> unwind_ids;
+
+    int nunwind;
+
     int nconst;
 
     std::map<std::string , int> constant_map;
 
+    int nmethods;
+
+    int switch_case;
+
     std::iostream& os_hdr_ext;
 
     std::iostream& os_src_ext;
@@ -421,5 +472,21 @@ namespace coder_compiler
     std::vector<std::string> nested_fcn_names;
 
     std::vector<symscope_ptr > fcn_scopes;
+
+    scalar_map scalar_vars;
+
+    std::map<std::string, std::string> callees;
+
+    constant_folder folder;
+
+    std::string profile_name;
+
+    bool parfor_enabled;
+
+    bool parfor_body;
+
+    bool parfor_unlocked;
+
+    bool boxed_loops;
   };
 }
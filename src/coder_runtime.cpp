@@ -7,6 +7,8 @@ namespace coder_compiler
     static const std::string s = R"header(
 
 #include "version.h"
+#include <atomic>
+#include <exception>
 #include <functional>
 #include <initializer_list>
 #include <type_traits>
@@ -48,6 +50,11 @@ namespace coder
 
   struct Symbol;
 
+  // An anonymous function that gets the copies of the variables that it
+  // captures as its last argument
+
+  typedef void (*capturing_function) (coder_value_list&, const octave_value_list&, int, Symbol *);
+
   typedef const Symbol& (*function_maker) ();
 
   struct coder_value
@@ -86,6 +93,8 @@ namespace coder
 
   octave_base_value* fcn2ov(stateless_function f);
 
+  octave_base_value* fcn2ov(capturing_function f, std::initializer_list<Symbol *> captures);
+
   octave_base_value* stdfcntoov (const std::function<void(coder_value_list&, const octave_value_list&, int)>& fcn);
 
   octave_base_value* stdfcntoov (std::function<void(coder_value_list&, const octave_value_list&, int)>&& fcn);
@@ -228,8 +237,15 @@ namespace coder
 
     virtual bool is_Tilde() {return false;}
 
+    virtual bool is_Index() {return false;}
+
     virtual octave_base_value * base_value () { return nullptr;}
 
+    // Stores the value of an expression that is a real scalar and can be
+    // evaluated without side effects in d.
+
+    virtual bool pure_scalar (const Endindex&, double&) { return false;}
+
     operator bool();
   };
 
@@ -288,6 +304,8 @@ namespace coder
 
     octave_base_value * base_value () { return get_value();}
 
+    bool pure_scalar (const Endindex&, double& d);
+
     void make_static (Symbol& static_sym, char type);
 
     void** get_reference() const
@@ -333,37 +351,39 @@ namespace coder
     bool isreference;
   };
 
+  // The function nargin, nargout, isargout, narginchk or nargoutchk of a
+  // compiled function. nargin and nargout without arguments evaluate to the
+  // count and the function object is only created when it is called with
+  // arguments or its handle is taken.
+
+  struct Narg_function
+  {
+    typedef octave_base_value* (*maker) (int count, coder_value_list& output);
+
+    Narg_function (int count, coder_value_list& output, maker make, bool is_count)
+    : count (count), output (output), make (make), is_count (is_count), fcn ()
+    {}
+
+    Symbol& function ();
+
+    int count;
+    coder_value_list& output;
+    maker make;
+    bool is_count;
+    Symbol fcn;
+  };
+
   struct Narg : public Expression
   {
-    Narg (Symbol& sym, Symbol& fun) : sym(sym) ,fun(fun) {}
+    Narg (Symbol& sym, Narg_function& fun) : sym(sym) ,fun(fun) {}
 
     coder_value
     evaluate(int nargout=0,
-      const Endindex& endkey=Endindex(), bool short_circuit=false)
-      {
-        if (sym.is_defined())
-          {
-            return sym.evaluate(nargout, endkey, short_circuit);
-          }
-        else
-          {
-            return fun.evaluate(nargout, endkey, short_circuit);
-          }
-      }
+      const Endindex& endkey=Endindex(), bool short_circuit=false);
 
     void
     evaluate_n(coder_value_list& output,int nargout=1,
-      const Endindex& endkey=Endindex(), bool short_circuit=false)
-    {
-      if (sym.is_defined())
-        {
-          return sym.evaluate_n(output, nargout, endkey, short_circuit);
-        }
-      else
-        {
-          return fun.evaluate_n(output, nargout, endkey, short_circuit);
-        }
-    }
+      const Endindex& endkey=Endindex(), bool short_circuit=false);
 
     coder_lvalue lvalue(coder_value_list& lst)
     {
@@ -376,28 +396,127 @@ namespace coder
 
     octave_base_value * base_value ()
     {
-      return (sym.is_defined() ? sym : fun).get_value();
+      return (sym.is_defined() ? sym : fun.function ()).get_value();
     }
 
     Symbol& sym;
-    Symbol& fun;
+    Narg_function& fun;
   };
 
   Symbol Copy (const Symbol& obj);
 
+  // The symbol of a function that is only called in a function body
+
+  inline Symbol& Callee (function_maker maker)
+  {
+    return const_cast<Symbol&> (maker ());
+  }
+
 template <typename T>
   const T& ConstCast (T&& t)
   {
     return t;
   }
 
+  // Number of entries and time in nanoseconds of a function or of a loop
+  // body that is built with the 'profile' option. The time of the recursive
+  // entries is only counted once.
+
+  class profile_site
+  {
+  public:
+
+    explicit profile_site (const char *name);
+
+    profile_site (const profile_site&) = delete;
+
+    profile_site& operator = (const profile_site&) = delete;
+
+    ~profile_site ();
+
+    const char *name;
+
+    std::atomic<unsigned long long> calls;
+
+    std::atomic<unsigned long long> time;
+
+    std::atomic<bool> recursive;
+
+    // the thread whose outermost active scope is of this site and the
+    // number of active scopes of the other threads
+
+    std::atomic<const void *> owner;
+
+    std::atomic<int> shared;
+  };
+
+  // Counts an entry of a profile_site and measures the time until the scope
+  // is left
+
+  class profile_scope
+  {
+  public:
+
+    explicit profile_scope (profile_site& site);
+
+    profile_scope (const profile_scope&) = delete;
+
+    profile_scope& operator = (const profile_scope&) = delete;
+
+    ~profile_scope ();
+
+  private:
+
+    profile_site& site;
+
+    profile_scope *parent;
+
+    long long start;
+
+    bool owner;
+
+    bool shared;
+  };
+
+  octave_value_list profile_report (const octave_value_list& args);
+
+  bool profile_autoload (const char *name, const char *accessor);
+
+  class method_cache_rep;
+
+  // Inline cache of the class methods that are called at a call site
+
+  class method_cache
+  {
+  public:
+
+    method_cache ()
+    : rep (nullptr)
+    {}
+
+    method_cache (const method_cache&) = delete;
+
+    method_cache& operator = (const method_cache&) = delete;
+
+    ~method_cache ();
+
+    octave_value find_method (const char *name, const octave_value& obj);
+
+  private:
+
+    method_cache_rep *rep;
+  };
+
   struct Index : LightweightExpression
   {
     Index(Ptr arg, const char *name, const char *type, Ptr_list_list&& arg_list)
-    : base(arg), name (name), idx_type(type), arg_list(arg_list){}
+    : base(arg), name (name), idx_type(type), arg_list(arg_list), methods (nullptr){}
+
+    Index(Ptr arg, const char *name, const char *type, Ptr_list_list&& arg_list, method_cache& methods)
+    : base(arg), name (name), idx_type(type), arg_list(arg_list), methods (&methods){}
 
     Index(Ptr arg, const char *type, Ptr_list_list&& arg_list)
-    : base(arg), name (nullptr), idx_type(type), arg_list(arg_list){}
+    : base(arg), name (nullptr), idx_type(type), arg_list(arg_list), methods (nullptr){}
 
     coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
 
@@ -406,8 +525,13 @@ template <typename T>
     coder_lvalue
     lvalue (coder_value_list&);
 
+    bool
+    assign_in_place (const Endindex& endkey, Ptr rhs, octave_value& rhs_val);
+
     Symbol * address () {return base->address ();}
 
+    bool is_Index() {return true;}
+
     Ptr base;
 
     const char *name;
@@ -415,6 +539,8 @@ template <typename T>
     const char *idx_type;
 
     Ptr_list_list& arg_list;
+
+    method_cache *methods;
   };
 
   struct Null : LightweightExpression
@@ -468,9 +594,20 @@ template <typename T>
 
     coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
 
+    bool pure_scalar (const Endindex&, double& d) { d = val; return true;}
+
     double val;
   };
 
+  struct bool_literal : Expression
+  {
+    explicit bool_literal(bool b) :val(b){  }
+
+    coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
+
+    bool val;
+  };
+
   struct int8_literal : Expression
   {
     explicit int8_literal(unsigned long long int d) :val(d){  }
@@ -633,6 +770,8 @@ template <typename T>
 
     coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
 
+    bool pure_scalar (const Endindex& endkey, double& d);
+
     Ptr a;
     Ptr b;
   };
@@ -643,6 +782,8 @@ template <typename T>
 
     coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
 
+    bool pure_scalar (const Endindex& endkey, double& d);
+
     Ptr a;
     Ptr b;
   };
@@ -1170,6 +1311,8 @@ template <typename T>
   {
     Anonymous(octave_base_value* arg);
 
+    Anonymous(stateless_function fcn);
+
     coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
 
     coder_value value;
@@ -1193,6 +1336,23 @@ template <typename T>
     Ptr_list_list& mat;
   };
 
+  // A matrix of native scalars with a shape known at translation time. The
+  // elements are in row major order.
+
+  struct ScalarMatrix : public LightweightExpression
+  {
+    ScalarMatrix(octave_idx_type rows, octave_idx_type cols, std::initializer_list<double>&& elems)
+    : rows(rows), cols(cols), elems(elems){}
+
+    coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
+
+    octave_idx_type rows;
+
+    octave_idx_type cols;
+
+    std::initializer_list<double>& elems;
+  };
+
   struct Cellc : public LightweightExpression
   {
     Cellc(Ptr_list_list&& expr) : cel(expr){}
@@ -1210,23 +1370,75 @@ template <typename T>
 
     coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
 
+    bool pure_scalar (const Endindex&, double& d);
+
     coder_value val;
   };
 
+  class switch_table_rep;
+
+  // A string case label of a switch_table with its length and the position
+  // of its case
+
+  struct string_case
+  {
+    const char *str;
+
+    std::size_t len;
+
+    int index;
+  };
+
+  // Hash table of the constant string and integer case labels of a switch
+  // command
+
+  class switch_table
+  {
+  public:
+
+    switch_table (std::initializer_list<string_case> strings, std::initializer_list<std::pair<double, int>> numbers);
+
+    switch_table (const switch_table&) = delete;
+
+    switch_table& operator = (const switch_table&) = delete;
+
+    ~switch_table ();
+
+    // the position of the first case that matches val, -1 if no case
+    // matches and -2 if val can't be looked up in the table
+
+    int find (const octave_value& val) const;
+
+  private:
+
+    switch_table_rep *rep;
+  };
+
   struct Switch
   {
     Switch() = delete;
 
-    Switch(Ptr expr) : val(expr->evaluate(1)){}
+    Switch(Ptr expr) : val(expr->evaluate(1)), match(-2){}
+
+    Switch(Ptr expr, const switch_table& table);
 
     bool operator()(Ptr label);
 
+    bool operator()(int n, Ptr label)
+    {
+      return match == -2 ? (*this)(label) : match == n;
+    }
+
     coder_value val;
+
+    int match;
   };
 
   struct End : public LightweightExpression
   {
     coder_value evaluate(int nargout=0, const Endindex& endkey=Endindex(), bool short_circuit=false);
+
+    bool pure_scalar (const Endindex& endkey, double& d);
   };
 
   struct MagicColon : public LightweightExpression
@@ -1300,6 +1512,16 @@ template <int size>
   void
   call_isargout (coder_value_list& output, int nargout, const coder_value_list& caller_output, const octave_value_list& arg, int nout);
 
+  octave_base_value* narginchk_function (int nargin, coder_value_list& output);
+
+  octave_base_value* nargoutchk_function (int nargout, coder_value_list& output);
+
+  octave_base_value* nargin_function (int nargin, coder_value_list& output);
+
+  octave_base_value* nargout_function (int nargout, coder_value_list& output);
+
+  octave_base_value* isargout_function (int nargout, coder_value_list& output);
+
   void
   call_feval (coder_value_list& output, const octave_value_list& args, int nargout);
 
@@ -1320,11 +1542,13 @@ template <int size>
     undefined_loop
   };
 
-  struct unwind_ex {};
-  struct break_unwind:unwind_ex {};
-  struct continue_unwind:unwind_ex {};
-  struct normal_unwind:unwind_ex {};
-  struct return_unwind:unwind_ex {};
+  enum unwind_state
+  {
+    unwind_normal,
+    unwind_break,
+    unwind_continue,
+    unwind_return
+  };
 
   struct unwindprotect
   {
@@ -1339,6 +1563,8 @@ template <int size>
 
   class struct_loop_rep;
 
+  class colon_range;
+
   class for_iterator
   {
   public:
@@ -1375,11 +1601,114 @@ template <int size>
     for_loop& operator=(for_loop const&)=delete;
     for_loop& operator=(for_loop &&)=delete;
     for_loop (Ptr lhs, Ptr expr, bool fast_loop);
+    for_loop (Ptr lhs, const colon_range& range, bool fast_loop);
     for_iterator begin() ;
     for_iterator end() ;
     ~for_loop();
   };
 
+  // elements of a range of doubles that is computed by Octave's colon
+  // operator. Used by the loops with a native loop variable.
+
+  class scalar_range
+  {
+  public:
+    scalar_range ()
+    : m_base (0), m_increment (0), m_final (0), m_numel (0)
+    {}
+    scalar_range (double base, double limit);
+    scalar_range (double base, double increment, double limit);
+    octave_idx_type numel () const { return m_numel; }
+    double elem (octave_idx_type i) const
+    {
+      return i < m_numel - 1 ? m_base + i * m_increment : m_final;
+    }
+  private:
+    double m_base;
+    double m_increment;
+    double m_final;
+    octave_idx_type m_numel;
+  };
+
+  // The range of a loop with a native loop variable whose bounds aren't
+  // known to be scalars at compile time. The bounds are evaluated once. If
+  // they are real double scalars the elements come from a scalar_range,
+  // otherwise value () is the result of the colon operator that is looped
+  // over by for_loop.
+
+  class colon_range
+  {
+  public:
+    colon_range (Ptr base, Ptr limit);
+    colon_range (Ptr base, Ptr increment, Ptr limit);
+    colon_range (const colon_range&)=delete;
+    colon_range& operator=(const colon_range&)=delete;
+    bool is_scalar () const { return m_is_scalar; }
+    octave_idx_type numel () const { return m_range.numel (); }
+    double elem (octave_idx_type i) const { return m_range.elem (i); }
+    octave_base_value* value () const { return m_value.val; }
+  private:
+    scalar_range m_range;
+    coder_value m_value;
+    bool m_is_scalar;
+  };
+
+  // Serializes the parts of the parfor loops that use the interpreter or
+  // Octave values because they aren't thread safe.
+
+  class interpreter_lock
+  {
+  public:
+    interpreter_lock ();
+    interpreter_lock (const interpreter_lock&)=delete;
+    interpreter_lock& operator=(const interpreter_lock&)=delete;
+    ~interpreter_lock ();
+    void lock ();
+    void unlock ();
+  private:
+    bool m_locked;
+  };
+
+  class parfor_loop_rep;
+
+  // A range of consecutive iterations of a parfor loop that runs on one
+  // thread.
+
+  class parfor_chunk
+  {
+  public:
+    parfor_chunk (const parfor_loop_rep *loop, octave_idx_type index, octave_idx_type first, octave_idx_type last, octave_idx_type numel)
+    : m_loop (loop), m_index (index), m_first (first), m_last (last), m_numel (numel)
+    {}
+    octave_idx_type index () const { return m_index; }
+    octave_idx_type first () const { return m_first; }
+    octave_idx_type last () const { return m_last; }
+    bool is_last () const { return m_last == m_numel; }
+    void set_loop_val (Symbol& var, octave_idx_type i) const;
+  private:
+    const parfor_loop_rep *m_loop;
+    octave_idx_type m_index;
+    octave_idx_type m_first;
+    octave_idx_type m_last;
+    octave_idx_type m_numel;
+  };
+
+  class parfor_loop
+  {
+    parfor_loop_rep* rep;
+  public:
+    parfor_loop()=delete;
+    parfor_loop(parfor_loop const&)=delete;
+    parfor_loop(parfor_loop &&)=delete;
+    parfor_loop& operator=(parfor_loop const&)=delete;
+    parfor_loop& operator=(parfor_loop &&)=delete;
+    explicit parfor_loop (octave_idx_type numel, Ptr maxproc = Ptr ());
+    explicit parfor_loop (Ptr expr, Ptr maxproc = Ptr ());
+    octave_idx_type chunks () const;
+    void run (const std::function<void(const parfor_chunk&)>& body);
+    ~parfor_loop ();
+  };
+
   class struct_loop
   {
     struct_loop_rep* rep;
@@ -1444,8 +1773,6 @@ template <int size>
     {\
       try_code\
     }\
-  catch (unwind_ex)\
-    { throw; }\
   catch (...)\
     {\
       recover_from_execution_excep ();\
@@ -1459,8 +1786,6 @@ template <int size>
     {\
       try_code\
     }\
-  catch (unwind_ex)\
-    { throw; }\
   catch (...)\
     {\
       recover_from_execution_excep ();\
@@ -1479,8 +1804,6 @@ template <int size>
     {\
       try_code\
     }\
-  catch (unwind_ex)\
-    { throw; }\
   catch (...)\
     {\
       recover_from_execution_excep ();\
@@ -1496,8 +1819,6 @@ template <int size>
     {\
       try_code\
     }\
-  catch (unwind_ex)\
-    { throw; }\
   catch (...)\
     {\
       recover_from_execution_excep ();\
@@ -1508,120 +1829,41 @@ template <int size>
 
 #endif
 
-#define UNWIND_PROTECT(unwind_protect_code , cleanup_code , return_propagates)\
+// The body of an unwind_protect block leaves it early by storing the reason
+// in the status variable of the block and jumping to its cleanup code.
+// After the cleanup code the exit code continues the break, continue or
+// return in the enclosing context.
+
+#define UNWIND_EXIT(id , status)\
 {\
-  try\
-    {\
-      try\
-        {\
-          {unwind_protect_code}\
-        }\
-      catch (...)\
-        {\
-          throw;\
-        }\
-      throw normal_unwind {};\
-    }\
-  catch (...)\
-    {\
-      try\
-        {\
-          try\
-            {\
-              throw;\
-            }\
-          catch (unwind_ex)\
-            {\
-              throw;\
-            }\
-          catch (...)\
-            {\
-              recover_from_execution_and_interrupt_excep ();\
-              throw;\
-            }\
-        }\
-      catch (...)\
-        {\
-          {cleanup_code}\
-          try\
-            {\
-              throw;\
-            }\
-          catch (normal_unwind)\
-            {\
-            }\
-          catch (return_unwind)\
-            {\
-              if (return_propagates) throw; else goto Return;\
-            }\
-          catch (...)\
-            {\
-              throw;\
-            }\
-        }\
-    }\
+  unwind_status_ ## id = status;\
+  goto unwind_cleanup_ ## id;\
 }
 
-#define UNWIND_PROTECT_LOOP(unwind_protect_code , cleanup_code , return_propagates , loop_propagates)\
+#define UNWIND_PROTECT(id , unwind_protect_code , cleanup_code , exit_code)\
 {\
+  unwind_state unwind_status_ ## id = unwind_normal;\
+  std::exception_ptr unwind_excep_ ## id;\
   try\
     {\
-      try\
-        {\
-          {unwind_protect_code}\
-        }\
-      catch (...)\
-        {\
-          throw;\
-        }\
-      throw normal_unwind {};\
+      unwind_protect_code\
     }\
   catch (...)\
     {\
+      unwind_excep_ ## id = std::current_exception ();\
       try\
         {\
-          try\
-            {\
-              throw;\
-            }\
-          catch (unwind_ex)\
-            {\
-              throw;\
-            }\
-          catch (...)\
-            {\
-              recover_from_execution_and_interrupt_excep ();\
-              throw;\
-            }\
+          recover_from_execution_and_interrupt_excep ();\
         }\
       catch (...)\
         {\
-          {cleanup_code}\
-          try\
-            {\
-              throw;\
-            }\
-          catch (normal_unwind)\
-            {\
-            }\
-          catch (return_unwind)\
-            {\
-              if (return_propagates) throw; else goto Return;\
-            }\
-          catch (break_unwind)\
-            {\
-              if (loop_propagates) throw; else break;\
-            }\
-          catch (continue_unwind)\
-            {\
-              if (loop_propagates) throw; else continue;\
-            }\
-          catch (...)\
-            {\
-              throw;\
-            }\
         }\
     }\
+  unwind_cleanup_ ## id:\
+  {cleanup_code}\
+  if (unwind_excep_ ## id)\
+    std::rethrow_exception (unwind_excep_ ## id);\
+  {exit_code}\
 }
 
 #define WHILE(condition , loop_body)\
@@ -1643,52 +1885,38 @@ template <int size>
   } while ( !con );\
 }
 
-#define NARGINCHK_MAKER Symbol narginchk_maker(([&args]()\
-{\
-  int nargin = ovl_length(args);\
-  return Symbol(fcn2ov(\
-  [nargin](coder_value_list& output, const octave_value_list& arg, int nout)->void\
-    {\
-      return call_narginchk (output, nargin, arg);\
-    }));\
-})());
+#if defined (CODER_PROFILE)
+#define PROFILE_SITE(name)\
+  static profile_site Profile (name);
+
+#define PROFILE_ENTER\
+  const profile_scope Profile_scope (Profile);
+#else
+#define PROFILE_SITE(name)
+#define PROFILE_ENTER
+#endif
+
+#define PROFILE_SCOPE(name)\
+  PROFILE_SITE(name)\
+  PROFILE_ENTER
+
+#define NARGINCHK_MAKER Narg_function narginchk_maker (ovl_length (args), output, narginchk_function, false);
 
 #define NARGINCHK Narg(narginchk_, narginchk_maker)
 
-#define NARGOUTCHK_MAKER Symbol narginchk_maker(fcn2ov(\
-  [nargout](coder_value_list& output, const octave_value_list& arg, int nout)->void \
-  {\
-    return call_nargoutchk (output, nargout, arg, nout);\
-  }))
+#define NARGOUTCHK_MAKER Narg_function nargoutchk_maker (nargout, output, nargoutchk_function, false);
 
 #define NARGOUTCHK Narg(nargoutchk_, nargoutchk_maker)
 
-#define NARGIN_MAKER Symbol nargin_maker((\
-  [&args]()\
-  {\
-    int nargin = ovl_length(args);\
-    return Symbol (fcn2ov ( \
-      [nargin](coder_value_list& output, const octave_value_list& arg, int nout)->void \
-      {\
-        return call_nargin (output, nargin, arg, nout);\
-      }));\
-  })());
+#define NARGIN_MAKER Narg_function nargin_maker (ovl_length (args), output, nargin_function, true);
 
 #define NARGIN Narg(nargin_, nargin_maker)
 
-#define NARGOUT_MAKER Symbol nargout_maker(fcn2ov(\
-  [nargout](coder_value_list& output, const octave_value_list& arg, int nout)->void \
-  {\
-    return call_nargout (output, nargout, arg, nout);\
-  }));
+#define NARGOUT_MAKER Narg_function nargout_maker (nargout, output, nargout_function, true);
 
 #define NARGOUT Narg(nargout_, nargout_maker)
 
-#define ISARGOUT_MAKER Symbol isargout_maker(fcn2ov(\
-  [nargout, &output](coder_value_list& out, const octave_value_list& arg, int nout)->void\
-  {\
-    return call_isargout (out, nargout, output, arg, nout);\
-  }));
+#define ISARGOUT_MAKER Narg_function isargout_maker (nargout, output, isargout_function, false);
 
 #define ISARGOUT Narg(isargout_, isargout_maker)
 
@@ -1717,9 +1945,28 @@ template <int size>
   {
     static const std::string s = R"source(
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include "error.h"
 #include "ov-null-mat.h"
 #include "ov-bool.h"
+#include "ov-scalar.h"
+#include "ov-re-mat.h"
+#include "ov-bool-mat.h"
+#include "ov-str-mat.h"
 #include "Matrix.h"
 #include "parse.h"
 #include "dynamic-ld.h"
@@ -1732,6 +1979,9 @@ template <int size>
 #include "ov-cs-list.h"
 #include "ov-struct.h"
 #include "quit.h"
+#include "input.h"
+#include "dirfns.h"
+#include "oct-time.h"
 
 #if defined (CODER_BUILDMODE_NOT_SINGLE)
 #include "coder.h"
@@ -1771,6 +2021,35 @@ namespace coder
   GETMEMBER(octave_base_value_count, octave_base_value, octave::refcount<octave_idx_type>, count)
 #endif
 
+#if OCTAVE_MAJOR_VERSION >= 7
+  GETMEMBER(octave_matrix_array, octave_base_matrix<NDArray>, NDArray, m_matrix)
+  GETMEMBER(octave_matrix_typ, octave_base_matrix<NDArray>, MatrixType *, m_typ)
+  GETMEMBER(octave_matrix_idx_cache, octave_base_matrix<NDArray>, octave::idx_vector *, m_idx_cache)
+  GETMEMBER(octave_bool_matrix_typ, octave_base_matrix<boolNDArray>, MatrixType *, m_typ)
+  GETMEMBER(octave_bool_matrix_idx_cache, octave_base_matrix<boolNDArray>, octave::idx_vector *, m_idx_cache)
+#else
+  GETMEMBER(octave_matrix_array, octave_base_matrix<NDArray>, NDArray, matrix)
+  GETMEMBER(octave_matrix_typ, octave_base_matrix<NDArray>, MatrixType *, typ)
+  GETMEMBER(octave_matrix_idx_cache, octave_base_matrix<NDArray>, idx_vector *, idx_cache)
+  GETMEMBER(octave_bool_matrix_typ, octave_base_matrix<boolNDArray>, MatrixType *, typ)
+  GETMEMBER(octave_bool_matrix_idx_cache, octave_base_matrix<boolNDArray>, idx_vector *, idx_cache)
+#endif
+
+  // names the protected buffer type of an array
+
+  struct ndarray_buffer : public NDArray
+  {
+    typedef NDArray::ArrayRep type;
+  };
+
+#if OCTAVE_MAJOR_VERSION >= 7
+  GETMEMBER(ndarray_rep, Array<double>, ndarray_buffer::type *, m_rep)
+  GETMEMBER(ndarray_slice_data, Array<double>, double *, m_slice_data)
+#else
+  GETMEMBER(ndarray_rep, Array<double>, ndarray_buffer::type *, rep)
+  GETMEMBER(ndarray_slice_data, Array<double>, double *, slice_data)
+#endif
+
 #if OCTAVE_MAJOR_VERSION >= 6
   GETMEMBER(base_fcn_handle_name, octave::base_fcn_handle, std::string, m_name)
   GETMEMBER(octave_fcn_handle_rep, octave_fcn_handle, std::shared_ptr<octave::base_fcn_handle>, m_rep)
@@ -1839,55 +2118,143 @@ namespace coder
     grab (val);
   }
 
-  class value_list_pool
+  // The number of cached lists of each length and the length of the longest
+  // cached list. It can be set with -DCODER_VALUE_LIST_POOL_CAPACITY=n in
+  // the compiler options. When CODER_VALUE_LIST_POOL_STATS is defined each
+  // thread prints the allocations and misses of its pool when the pool is
+  // freed, so the capacity can be tuned for a workload.
+  // The default is the capacity of the pool before the overflow pool was
+  // added, so without the option the memory that a thread keeps is unchanged.
+
+#ifndef CODER_VALUE_LIST_POOL_CAPACITY
+#  define CODER_VALUE_LIST_POOL_CAPACITY 10
+#endif
+
+  // Lists that don't fit in the pool of a thread are moved to a shared
+  // overflow pool that has the same capacity. The threads take lists from
+  // the overflow when their own pool is empty.
+
+  class value_list_overflow
   {
   public:
     using List = std::list<octave_value_list>;
-    using iterator = List::iterator;
 
-    value_list_pool ()
-    : cache(capacity)
-    {
-      for (size_t i = 0 ; i < capacity; i++)
-        for (size_t j = 0 ; j < capacity; j++)
-          cache[i].emplace_back (octave_value_list (i));
-    }
+    value_list_overflow (size_t capacity)
+    : m_mutex (), m_capacity (capacity), m_cache (capacity)
+    {}
 
-    List alloc (size_t sz)
+    bool take (size_t sz, List& list)
     {
-      if (sz < capacity && ! cache[sz].empty ())
-        {
-          List retval;
+      std::lock_guard<std::mutex> guard (m_mutex);
 
-          retval.splice (retval.end (), cache[sz], cache[sz].begin ());
+      if (m_cache[sz].empty ())
+        return false;
 
-          return retval;
-        }
+      list.splice (list.end (), m_cache[sz], m_cache[sz].begin ());
 
-      return {octave_value_list (sz)};
+      return true;
     }
 
-    void free (List& list)
+    bool give (size_t sz, List& list, List::iterator it)
     {
-      for (iterator it = list.begin(); it != list.end (); )
-        {
-          const octave_idx_type sz = it->length ();
+      std::lock_guard<std::mutex> guard (m_mutex);
 
-          if (sz < (octave_idx_type)capacity && cache[sz].size () < capacity )
-            {
-              for (octave_idx_type i = 0 ;i < sz; i++)
-                (*it) (i) = octave_value ();
+      if (m_cache[sz].size () >= m_capacity)
+        return false;
 
-              cache[sz].splice (cache[sz].end (), list, it++);
+      m_cache[sz].splice (m_cache[sz].end (), list, it);
+
+      return true;
+    }
+
+  private:
+
+    std::mutex m_mutex;
+
+    const size_t m_capacity;
+
+    std::vector<List> m_cache;
+  };
+
+  class value_list_pool
+  {
+  public:
+    using List = std::list<octave_value_list>;
+    using iterator = List::iterator;
+
+    value_list_pool ()
+    : cache(capacity)
+#ifdef CODER_VALUE_LIST_POOL_STATS
+      , allocs (0), misses (0)
+#endif
+    {
+      for (size_t i = 0 ; i < capacity; i++)
+        for (size_t j = 0 ; j < capacity; j++)
+          cache[i].emplace_back (octave_value_list (i));
+    }
+
+#ifdef CODER_VALUE_LIST_POOL_STATS
+    ~value_list_pool ()
+    {
+      std::fprintf (stderr, "coder: value list pool: %zu allocations, %zu misses\n", allocs, misses);
+    }
+#endif
+
+    List alloc (size_t sz)
+    {
+#ifdef CODER_VALUE_LIST_POOL_STATS
+      allocs++;
+#endif
+      if (sz < capacity)
+        {
+          List retval;
+
+          if (! cache[sz].empty ())
+            retval.splice (retval.end (), cache[sz], cache[sz].begin ());
+          else if (! overflow ().take (sz, retval))
+            {
+#ifdef CODER_VALUE_LIST_POOL_STATS
+              misses++;
+#endif
+              retval.emplace_back (octave_value_list (sz));
+            }
+
+          return retval;
+        }
+#ifdef CODER_VALUE_LIST_POOL_STATS
+      misses++;
+#endif
+      return {octave_value_list (sz)};
+    }
+
+    void free (List& list)
+    {
+      for (iterator it = list.begin(); it != list.end (); )
+        {
+          const octave_idx_type sz = it->length ();
+
+          iterator next = std::next (it);
+
+          if (sz < (octave_idx_type)capacity)
+            {
+              for (octave_idx_type i = 0 ;i < sz; i++)
+                (*it) (i) = octave_value ();
+
+              if (cache[sz].size () < capacity)
+                cache[sz].splice (cache[sz].end (), list, it);
+              else if (! overflow ().give (sz, list, it))
+                list.erase (it);
             }
           else if (cache[0].size () < capacity)
             {
               it->clear ();
 
-              cache[0].splice (cache[0].end (), list, it++);
+              cache[0].splice (cache[0].end (), list, it);
             }
           else
-            it = list.erase (it);
+            list.erase (it);
+
+          it = next;
         }
     }
 
@@ -1898,47 +2265,146 @@ namespace coder
 
   private:
 
-    const size_t capacity = 10;
+    static value_list_overflow& overflow ()
+    {
+      static value_list_overflow lists (CODER_VALUE_LIST_POOL_CAPACITY);
+
+      return lists;
+    }
+
+    const size_t capacity = CODER_VALUE_LIST_POOL_CAPACITY;
 
     std::vector<std::list<octave_value_list>> cache;
+#ifdef CODER_VALUE_LIST_POOL_STATS
+    size_t allocs;
+
+    size_t misses;
+#endif
   };
 
-  namespace Pool
+  // The caches of a thread. A thread_local object with a destructor keeps
+  // the .oct file mapped after dlclose, so Octave would run the old code of
+  // a rebuilt function. Each thread only keeps a pointer to its caches. The
+  // parfor threads free them before they exit and the caches of the other
+  // threads are freed when the .oct file is unloaded.
+
+  class thread_caches;
+
+  static thread_local thread_caches *current_thread_caches = nullptr;
+
+  class thread_caches
   {
-    static value_list_pool& pool ()
+  public:
+
+    static thread_caches& get ()
     {
-      static value_list_pool list_pool;
+      if (! current_thread_caches)
+        {
+          current_thread_caches = new thread_caches ();
+
+          registry ().add (current_thread_caches);
+        }
 
-      return list_pool;
+      return *current_thread_caches;
     }
 
-    static value_list_pool::List alloc (size_t sz = 0)
+    static void release ()
     {
-      return pool ().alloc (sz);
+      if (current_thread_caches)
+        {
+          registry ().remove (current_thread_caches);
+
+          delete current_thread_caches;
+
+          current_thread_caches = nullptr;
+        }
     }
 
-    static void free (value_list_pool::List& list)
+    value_list_pool list_pool;
+
+    std::vector<char> bitidx;
+
+    // the handles of the functions of the generated code
+
+    std::unordered_map<function_maker, octave_value> handles;
+
+    // the handles of the anonymous functions that don't capture variables
+
+    std::unordered_map<stateless_function, octave_value> anonymous_handles;
+
+  private:
+
+    class caches_registry
     {
-      return pool ().free (list);
+    public:
+
+      caches_registry ()
+      : m_mutex (), m_caches ()
+      {}
+
+      ~caches_registry ()
+      {
+        for (auto *c : m_caches)
+          delete c;
+      }
+
+      void add (thread_caches *c)
+      {
+        std::lock_guard<std::mutex> guard (m_mutex);
+
+        m_caches.push_back (c);
+      }
+
+      void remove (thread_caches *c)
+      {
+        std::lock_guard<std::mutex> guard (m_mutex);
+
+        m_caches.erase (std::find (m_caches.begin (), m_caches.end (), c));
+      }
+
+    private:
+
+      std::mutex m_mutex;
+
+      std::vector<thread_caches *> m_caches;
+    };
+
+    thread_caches ()
+    : list_pool (), bitidx (), handles (), anonymous_handles ()
+    {
+      bitidx.reserve (list_pool.max_capacity ());
     }
 
-    static size_t max_capacity ()
+    static caches_registry& registry ()
     {
-      return pool ().max_capacity ();
+      static caches_registry caches;
+
+      return caches;
     }
-    static std::vector<char> create_bitidx()
+  };
+
+  namespace Pool
+  {
+    // each thread has its own pool
+
+    static value_list_pool& pool ()
     {
-      std::vector<char> idx;
+      return thread_caches::get ().list_pool;
+    }
 
-      idx.reserve (max_capacity ());
+    static value_list_pool::List alloc (size_t sz = 0)
+    {
+      return pool ().alloc (sz);
+    }
 
-      return idx;
+    static void free (value_list_pool::List& list)
+    {
+      return pool ().free (list);
     }
+
     static std::vector<char>& bitidx ()
     {
-      static std::vector<char> idx = create_bitidx();
-
-      return idx;
+      return thread_caches::get ().bitidx;
     }
   }
 
@@ -2320,6 +2786,95 @@ namespace coder
                                          "coder_stateful_function",
                                          "coder_stateful_function");
 
+  // The function object of an anonymous function that captures at most
+  // max_captures variables. The copies of the variables are kept in the
+  // object itself, so unlike a lambda in a std::function creating the
+  // handle doesn't allocate a closure.
+
+  class
+  coder_capturing_function : public coder_function_base ,public octave_function
+  {
+  public:
+
+    static const int max_captures = 8;
+
+    coder_capturing_function():f(), n(0){}
+
+    coder_capturing_function(capturing_function fun, std::initializer_list<Symbol *> syms):
+    f(fun), n(0)
+    {
+      if (syms.size () > max_captures)
+        error ("coder: too many captured variables of an anonymous function");
+
+      for (Symbol *sym : syms)
+        new (&captures ()[n++]) Symbol (*sym);
+    }
+
+    ~coder_capturing_function ()
+    {
+      for (int i = 0; i < n; i++)
+        captures ()[i].~Symbol ();
+    }
+
+    octave_function * function_value (bool = false) { return this; }
+
+    octave_value
+    subsasgn (const std::string& type,
+                            const std::list<octave_value_list>& idx,
+                            const octave_value& rhs)
+    {
+      octave_value retval;
+      return retval.subsasgn (type, idx, rhs);
+    }
+
+    void
+    call (coder_value_list& output, int nargout = 0,
+      const octave_value_list& args = octave_value_list ())
+    {
+      f(output, args, nargout, captures ());
+    }
+
+    octave_value_list
+    call(octave::tree_evaluator& tw, int nargout = 0,
+      const octave_value_list& args = octave_value_list ())
+    {
+      coder_value_list result;
+
+      f(result, args, nargout, captures ());
+
+      octave_value_list retval = result.back ();
+
+      retval.make_storable_values ();
+
+      if (retval.length () == 1 && retval.xelem (0).is_undefined ())
+        retval.clear ();
+
+      return retval;
+    }
+
+#if OCTAVE_MAJOR_VERSION >= 6
+    octave_value_list
+    execute(octave::tree_evaluator& tw, int nargout = 0,
+      const octave_value_list& args = octave_value_list ())
+    {
+      return call (tw, nargout, args);
+    }
+#endif
+
+  private:
+
+    Symbol *captures () { return reinterpret_cast<Symbol *> (storage); }
+
+    capturing_function f;
+    int n;
+    typename std::aligned_storage<sizeof (Symbol), alignof (Symbol)>::type storage[max_captures];
+    DECLARE_OV_TYPEID_FUNCTIONS_AND_DATA
+  };
+
+  DEFINE_OV_TYPEID_FUNCTIONS_AND_DATA (coder_capturing_function,
+                                         "coder_capturing_function",
+                                         "coder_capturing_function");
+
   octave_base_value* fcn2ov(coder_function::fcn f)
   {
     return new coder_function(f);
@@ -2335,6 +2890,11 @@ namespace coder
     return new coder_stateless_function(f);
   }
 
+  octave_base_value* fcn2ov(capturing_function f, std::initializer_list<Symbol *> captures)
+  {
+    return new coder_capturing_function(f, captures);
+  }
+
   octave_base_value* stdfcntoov (const std::function<void(coder_value_list&, const octave_value_list&,int)>& fcn)
   {
     return new coder_stateful_function(fcn);
@@ -3248,86 +3808,727 @@ namespace coder
     return octave_value (val, false);
   }
 
-  static bool
-  method_dispatch (coder_value_list& retval, const char * name, const octave_value_list& args, int nargout)
-  {
-    bool called = false;
+  // The profile sites that are alive in the order of their first entry
 
-    if (args.length() == 0)
-      return called;
+  class profile_registry
+  {
+  public:
 
-    auto& indexed_object = args(0);
+    static profile_registry& instance ()
+    {
+      static profile_registry registry;
 
-    if (indexed_object.isobject ())
-      {
-        std::string class_name = indexed_object.class_name ();
+      return registry;
+    }
 
-        octave::symbol_table& symtab = octave::interpreter::the_interpreter () ->get_symbol_table ();
+    void insert (profile_site *site)
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
 
-        octave_value meth = symtab.find_method (name, class_name);
+      m_sites.push_back (site);
+    }
 
-        if (meth.is_defined ())
-          {
-            octave::tree_evaluator& ev = octave::interpreter::the_interpreter () -> get_evaluator ();
+    void erase (profile_site *site)
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
 
-            retval.append (meth.function_value ()->call (ev, nargout, args));
+      m_sites.erase (std::remove (m_sites.begin (), m_sites.end (), site), m_sites.end ());
+    }
 
-            called = true;
-          }
-      }
+    template <typename F>
+    void for_each (F fcn)
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
 
-    return called;
-  }
+      for (auto site : m_sites)
+        fcn (*site);
+    }
 
-  coder_value
-  Index::evaluate ( int nargout, const Endindex& endkey, bool short_circuit)
-  {
-    coder_value_list result;
+  private:
 
-    evaluate_n (result, nargout, endkey, short_circuit);
+    std::mutex m_mutex;
 
-    octave_value_list& vlist = result.back ();
+    std::vector<profile_site *> m_sites;
+  };
 
-    coder_value retval;
+  // the innermost profile scope of the current thread
 
-    if (vlist.empty ())
-      {
-        octave_value tmp;
-        retval =  coder_value (tmp);
-      }
-    else
-      {
-        retval = coder_value(vlist(0));
-      }
+  static thread_local profile_scope *current_profile_scope = nullptr;
 
-    return retval;
+  static long long
+  profile_clock ()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+      std::chrono::steady_clock::now ().time_since_epoch ()).count ();
   }
 
-  void
-  Index::evaluate_n(coder_value_list& output, int nargout, const Endindex& endkey, bool short_circuit)
+  profile_site::profile_site (const char *name)
+  : name (name), calls (0), time (0), recursive (false), owner (nullptr), shared (0)
   {
-    coder_value_list& retval = output;
+    profile_registry::instance ().insert (this);
+  }
 
-    const char *type = idx_type;
+  profile_site::~profile_site ()
+  {
+    profile_registry::instance ().erase (this);
+  }
 
-    auto& args = arg_list;
+  // A scope is nested in a scope of the same site if its thread owns the
+  // site, so entering a scope takes constant time. The scopes of the thread
+  // are only searched when other threads also enter the site, e.g. a
+  // function that is called by the iterations of a parfor loop.
 
-    assert ( args.size () > 0);
+  profile_scope::profile_scope (profile_site& site)
+  : site (site), parent (current_profile_scope), start (-1), owner (false),
+    shared (false)
+  {
+    site.calls.fetch_add (1, std::memory_order_relaxed);
 
-    auto p_args = args.begin ();
+    const void *thread = &current_profile_scope;
 
-    const int n = args.size ();
+    const void *expected = nullptr;
 
-    int beg = 0;
+    bool nested = false;
 
-    octave_value base_expr_val;
+    bool search = false;
 
-    auto& expr = base;
+    if (site.owner.load (std::memory_order_relaxed) == thread)
+      nested = true;
+    else if (site.owner.compare_exchange_strong (expected, thread, std::memory_order_relaxed))
+      {
+        owner = true;
 
-    coder_value_list idx ;
+        // this thread may have entered the site before it was released
+
+        search = site.shared.load (std::memory_order_relaxed) > 0;
+      }
+    else
+      {
+        shared = true;
+
+        site.shared.fetch_add (1, std::memory_order_relaxed);
+
+        search = true;
+      }
+
+    if (search)
+      {
+        for (profile_scope *scope = parent; scope; scope = scope->parent)
+          if (&scope->site == &site)
+            {
+              nested = true;
+
+              break;
+            }
+      }
+
+    if (nested)
+      site.recursive.store (true, std::memory_order_relaxed);
+    else
+      start = profile_clock ();
+
+    current_profile_scope = this;
+  }
+
+  profile_scope::~profile_scope ()
+  {
+    current_profile_scope = parent;
+
+    if (start >= 0)
+      site.time.fetch_add (profile_clock () - start, std::memory_order_relaxed);
+
+    if (owner)
+      site.owner.store (nullptr, std::memory_order_relaxed);
+
+    if (shared)
+      site.shared.fetch_sub (1, std::memory_order_relaxed);
+  }
+
+  // The profile in the form of the result of profile ('info') so it can be
+  // shown by profshow. coder_profile ('clear') resets the counters.
+
+  octave_value_list
+  profile_report (const octave_value_list& args)
+  {
+    profile_registry& registry = profile_registry::instance ();
+
+    if (args.length () == 1 && args(0).is_string () && args(0).string_value () == "clear")
+      {
+        registry.for_each ([](profile_site& site)
+          {
+            site.calls = 0;
+
+            site.time = 0;
+
+            site.recursive = false;
+          });
+
+        return ovl ();
+      }
+
+    if (args.length () != 0)
+      error ("coder_profile: invalid arguments");
+
+    std::vector<std::string> names;
+
+    std::vector<double> times;
+
+    std::vector<double> calls;
+
+    std::vector<bool> recursive;
+
+    // the sites with the same name are reported together. A loop whose
+    // bounds are checked at run time has one site for both versions of its
+    // body but the loops inside of the body are generated twice.
+
+    std::unordered_map<std::string, std::size_t> index;
+
+    registry.for_each ([&](profile_site& site)
+      {
+        if (site.calls == 0)
+          return;
+
+        auto it = index.find (site.name);
+
+        if (it != index.end ())
+          {
+            times[it->second] += site.time * 1e-9;
+
+            calls[it->second] += site.calls;
+
+            if (site.recursive)
+              recursive[it->second] = true;
+
+            return;
+          }
+
+        index[site.name] = names.size ();
+
+        names.push_back (site.name);
+
+        times.push_back (site.time * 1e-9);
+
+        calls.push_back (site.calls);
+
+        recursive.push_back (site.recursive);
+      });
+
+    octave_idx_type n = names.size ();
+
+    Cell name_cell (n, 1);
+
+    Cell time_cell (n, 1);
+
+    Cell calls_cell (n, 1);
+
+    Cell recursive_cell (n, 1);
+
+    Cell empty_cell (n, 1, octave_value (::Matrix ()));
+
+    for (octave_idx_type i = 0; i < n; i++)
+      {
+        name_cell(i) = names[i];
+
+        time_cell(i) = times[i];
+
+        calls_cell(i) = calls[i];
+
+        recursive_cell(i) = bool (recursive[i]);
+      }
+
+    octave_map table (dim_vector (n, 1));
+
+    table.assign ("FunctionName", name_cell);
+
+    table.assign ("TotalTime", time_cell);
+
+    table.assign ("NumCalls", calls_cell);
+
+    table.assign ("IsRecursive", recursive_cell);
+
+    table.assign ("Parents", empty_cell);
+
+    table.assign ("Children", empty_cell);
+
+    octave_scalar_map retval;
+
+    retval.assign ("FunctionTable", table);
+
+    retval.assign ("Hierarchical", octave_map (dim_vector (0, 1)));
+
+    return ovl (retval);
+  }
+
+  // Makes the profile accessor of the .oct file that defines the function
+  // name callable. Each .oct file calls it once, at the first call of its
+  // function.
+
+  bool
+  profile_autoload (const char *name, const char *accessor)
+  {
+    octave::symbol_table& symtab = octave::interpreter::the_interpreter ()->get_symbol_table ();
+
+    octave_value fcn = symtab.find_function (name);
+
+    octave_function *f = fcn.is_defined () ? fcn.function_value (true) : nullptr;
+
+    if (f && ! f->fcn_file_name ().empty ())
+      octave::feval ("autoload", ovl (accessor, f->fcn_file_name ()));
+
+    return true;
+  }
+
+  // The methods that are found for the last few classes of the objects that
+  // are passed to a call site. A class without the method is also cached,
+  // with an undefined method, so a call site that mostly gets such objects
+  // doesn't search the load path on each call. Like the function table of
+  // Octave the cache is refreshed after each prompt and after a change of
+  // the working directory, when Octave checks whether the functions are out
+  // of date.
+
+  class method_cache_rep
+  {
+  public:
+
+    method_cache_rep ()
+    : m_entries (), m_next (0), m_prompt_time (Vlast_prompt_time),
+      m_chdir_time (Vlast_chdir_time)
+    {}
+
+    octave_value find_method (const char *name, const std::string& class_name)
+    {
+      if (m_prompt_time != Vlast_prompt_time || m_chdir_time != Vlast_chdir_time)
+        {
+          for (auto& e : m_entries)
+            e = entry ();
+
+          m_prompt_time = Vlast_prompt_time;
+
+          m_chdir_time = Vlast_chdir_time;
+        }
+
+      for (const auto& e : m_entries)
+        if (! e.class_name.empty () && e.class_name == class_name)
+          return e.method;
+
+      octave::symbol_table& symtab = octave::interpreter::the_interpreter () ->get_symbol_table ();
+
+      octave_value meth = symtab.find_method (name, class_name);
+
+      m_entries[m_next] = entry {class_name, meth};
+
+      m_next = (m_next + 1) % size;
+
+      return meth;
+    }
+
+  private:
+
+    struct entry
+    {
+      std::string class_name;
+
+      octave_value method;
+    };
+
+    static const int size = 4;
+
+    entry m_entries[size];
+
+    int m_next;
+
+    octave::sys::time m_prompt_time;
+
+    octave::sys::time m_chdir_time;
+  };
+
+  method_cache::~method_cache ()
+  {
+    delete rep;
+  }
+
+  octave_value
+  method_cache::find_method (const char *name, const octave_value& obj)
+  {
+    if (! rep)
+      rep = new method_cache_rep ();
+
+    return rep->find_method (name, obj.class_name ());
+  }
+
+  static bool
+  method_dispatch (coder_value_list& retval, const char * name, const octave_value_list& args, int nargout, method_cache *cache = nullptr)
+  {
+    bool called = false;
+
+    if (args.length() == 0)
+      return called;
+
+    auto& indexed_object = args(0);
+
+    if (indexed_object.isobject ())
+      {
+        octave_value meth;
+
+        if (cache)
+          meth = cache->find_method (name, indexed_object);
+        else
+          {
+            octave::symbol_table& symtab = octave::interpreter::the_interpreter () ->get_symbol_table ();
+
+            meth = symtab.find_method (name, indexed_object.class_name ());
+          }
+
+        if (meth.is_defined ())
+          {
+            octave::tree_evaluator& ev = octave::interpreter::the_interpreter () -> get_evaluator ();
+
+            retval.append (meth.function_value ()->call (ev, nargout, args));
+
+            called = true;
+          }
+      }
+
+    return called;
+  }
+
+  static bool
+  is_real_scalar (const octave_base_value *val, double& d)
+  {
+    static const int scalar_id = octave_scalar::static_type_id ();
+
+    if (! val || val->type_id () != scalar_id)
+      return false;
+
+    d = static_cast<const octave_scalar *> (val)->octave_scalar::double_value ();
+
+    return true;
+  }
+
+  // A numeric or logical array whose elements can be extracted directly
+
+  static bool
+  is_plain_array (const octave_base_value *val)
+  {
+    return val->is_matrix_type () && (val->isnumeric () || val->islogical ())
+           && ! val->issparse () && ! val->is_range () && ! val->isobject ();
+  }
+
+  bool
+  Symbol::pure_scalar (const Endindex&, double& d)
+  {
+    return is_real_scalar (get_value (), d);
+  }
+
+  bool
+  Constant::pure_scalar (const Endindex&, double& d)
+  {
+    return is_real_scalar (val.val, d);
+  }
+
+  bool
+  End::pure_scalar (const Endindex& endkey, double& d)
+  {
+    const octave_base_value *obj = endkey.indexed_object;
+
+    if (! obj || ! is_plain_array (obj))
+      return false;
+
+    if (endkey.num_indices == 1)
+      d = obj->numel ();
+    else
+      d = obj->dims ().redim (endkey.num_indices) (endkey.index_position);
+
+    return true;
+  }
+
+  // The linear index of A(i) or A(i,j) for an array and real integer valued
+  // scalar subscripts inside the bounds of the array.
+
+  static bool
+  scalar_subscript (octave_base_value *val, const Ptr_list& args, octave_idx_type& linear)
+  {
+    const int nargs = args.size ();
+
+    if (nargs < 1 || nargs > 2 || ! is_plain_array (val))
+      return false;
+
+    Endindex endkey {val, "(", nullptr, 0, nargs};
+
+    octave_idx_type sub[2];
+
+    int k = 0;
+
+    for (Ptr arg : args)
+      {
+        endkey.index_position = k;
+
+        double d;
+
+        if (! arg->pure_scalar (endkey, d))
+          return false;
+
+        // NaN, Inf and out of range values are left to the generic index
+        // so that Octave reports the error
+
+        if (! std::isfinite (d) || d < 1 || d != std::trunc (d)
+            || d >= static_cast<double> (std::numeric_limits<octave_idx_type>::max ()))
+          return false;
+
+        octave_idx_type i = static_cast<octave_idx_type> (d);
+
+        sub[k++] = i - 1;
+      }
+
+    octave_idx_type numel = val->numel ();
+
+    linear = sub[0];
+
+    if (nargs == 2)
+      {
+        octave_idx_type rows = val->dims ()(0);
+
+        if (sub[0] >= rows || sub[1] >= numel / rows)
+          return false;
+
+        linear += sub[1] * rows;
+      }
+    else if (linear >= numel)
+      return false;
+
+    return true;
+  }
+
+  bool
+  Plus::pure_scalar (const Endindex& endkey, double& d)
+  {
+    double x, y;
+
+    if (! a->pure_scalar (endkey, x) || ! b->pure_scalar (endkey, y))
+      return false;
+
+    d = x + y;
+
+    return true;
+  }
+
+  bool
+  Minus::pure_scalar (const Endindex& endkey, double& d)
+  {
+    double x, y;
+
+    if (! a->pure_scalar (endkey, x) || ! b->pure_scalar (endkey, y))
+      return false;
+
+    d = x - y;
+
+    return true;
+  }
+
+  // Whether A(i) with a scalar subscript is one past the end of A
+
+  static bool
+  append_subscript (octave_base_value *val, const Ptr_list& args)
+  {
+    if (args.size () != 1 || ! is_plain_array (val))
+      return false;
+
+    Endindex endkey {val, "(", nullptr, 0, 1};
+
+    double d;
+
+    return (*args.begin ())->pure_scalar (endkey, d) && d == val->numel () + 1;
+  }
+
+  // A(i) and A(i,j) with scalar subscripts read the element directly,
+  // without building the index list. The result is undefined if the fast
+  // path doesn't apply.
+
+  static octave_value
+  scalar_element (octave_base_value *val, const Ptr_list& args)
+  {
+    octave_idx_type linear;
+
+    if (! scalar_subscript (val, args, linear))
+      return octave_value ();
+
+    return val->fast_elem_extract (linear);
+  }
+
+  // Stores an element of a double or logical array that is only referenced
+  // by one variable in place. Arrays that cache their matrix type or an
+  // index vector take the generic path that clears the caches.
+
+  template <typename MT, typename TypeTag, typename IdxTag>
+  static bool
+  has_cached_info (octave_base_value *val)
+  {
+    auto *mat = static_cast<octave_base_matrix<MT> *> (val);
+
+    return mat->*get (TypeTag ()) || mat->*get (IdxTag ());
+  }
+
+  static bool
+  assign_element (octave_base_value *val, octave_idx_type linear, const octave_value& rhs)
+  {
+    static const int matrix_id = octave_matrix::static_type_id ();
+
+    static const int bool_matrix_id = octave_bool_matrix::static_type_id ();
+
+    if (val->*get (octave_base_value_count ()) != 1)
+      return false;
+
+    const int id = val->type_id ();
+
+    if (id == matrix_id)
+      {
+        if (has_cached_info<NDArray, octave_matrix_typ, octave_matrix_idx_cache> (val))
+          return false;
+      }
+    else if (id == bool_matrix_id)
+      {
+        if (has_cached_info<boolNDArray, octave_bool_matrix_typ, octave_bool_matrix_idx_cache> (val))
+          return false;
+      }
+    else
+      return false;
+
+    return val->fast_elem_insert (linear, rhs);
+  }
+
+  // Whether Array::resize1 can append an element to the vector in place,
+  // i.e. the vector is the only user of its buffer and the buffer has room
+  // after it.
+
+  static bool
+  has_room (NDArray& a)
+  {
+    const ndarray_buffer::type *rep = a.*get (ndarray_rep ());
+
+    const double *end = a.*get (ndarray_slice_data ()) + a.numel ();
+#if OCTAVE_MAJOR_VERSION >= 7
+    return rep->m_count == 1 && end < rep->m_data + rep->m_len;
+#else
+    return rep->count == 1 && end < rep->data + rep->len;
+#endif
+  }
+
+  // Gives a vector room for capacity elements. The vector becomes a slice of
+  // a larger buffer that Array::resize1 fills in place when it grows.
+
+  static void
+  reserve_vector (NDArray& a, octave_idx_type capacity)
+  {
+    const octave_idx_type n = a.numel ();
+
+    const dim_vector dv = a.dims ();
+
+    NDArray buf (dim_vector (capacity, 1));
+
+    std::copy_n (a.data (), n, buf.fortran_vec ());
+#if OCTAVE_MAJOR_VERSION >= 7
+    a = buf.index (octave::idx_vector (0, n)).reshape (dv);
+#else
+    a = buf.index (idx_vector (0, n)).reshape (dv);
+#endif
+  }
+
+  // A(end+1) = x of a double vector that is only referenced by one variable.
+  // Array::resize1 grows a vector by at most 1024 elements when it runs out
+  // of room, so the capacity of longer vectors is doubled instead to make
+  // appending amortized O(1). The vector is copied to the doubled buffer
+  // before resize1 so that it is copied once.
+
+  static bool
+  append_element (octave_base_value *val, const octave_value& rhs)
+  {
+    static const int matrix_id = octave_matrix::static_type_id ();
+
+    static const int scalar_id = octave_scalar::static_type_id ();
+
+    if (val->*get (octave_base_value_count ()) != 1
+        || val->type_id () != matrix_id || rhs.type_id () != scalar_id
+        || has_cached_info<NDArray, octave_matrix_typ, octave_matrix_idx_cache> (val))
+      return false;
+
+    NDArray& a = static_cast<octave_base_matrix<NDArray> *> (val)->*get (octave_matrix_array ());
+
+    if (a.ndims () != 2 || (a.rows () > 1 && a.columns () != 1))
+      return false;
+
+    const octave_idx_type n = a.numel ();
+
+    if (n > 1024 && ! has_room (a))
+      reserve_vector (a, 2 * (n + 1));
+
+    a.resize1 (n + 1, rhs.double_value ());
+
+    return true;
+  }
+
+  coder_value
+  Index::evaluate ( int nargout, const Endindex& endkey, bool short_circuit)
+  {
+    coder_value_list result;
+
+    evaluate_n (result, nargout, endkey, short_circuit);
+
+    octave_value_list& vlist = result.back ();
+
+    coder_value retval;
+
+    if (vlist.empty ())
+      {
+        octave_value tmp;
+        retval =  coder_value (tmp);
+      }
+    else
+      {
+        retval = coder_value(vlist(0));
+      }
+
+    return retval;
+  }
+
+  void
+  Index::evaluate_n(coder_value_list& output, int nargout, const Endindex& endkey, bool short_circuit)
+  {
+    coder_value_list& retval = output;
+
+    const char *type = idx_type;
+
+    auto& args = arg_list;
+
+    assert ( args.size () > 0);
+
+    auto p_args = args.begin ();
+
+    const int n = args.size ();
+
+    int beg = 0;
+
+    octave_value base_expr_val;
+
+    auto& expr = base;
+
+    coder_value_list idx ;
 
     octave_base_value * symbol_value = expr->base_value ();
 
+    if (symbol_value && n == 1 && type[0] == '(')
+      {
+        octave_value elem = scalar_element (symbol_value, *p_args);
+
+        if (elem.is_defined ())
+          {
+            retval.clear ();
+
+            retval.append (elem);
+
+            return;
+          }
+      }
+
     if (symbol_value && type[beg] == '(')
       {
         if (true)
@@ -3356,7 +4557,7 @@ namespace coder
 
                         first_args.append (convert_to_const_vector( *p_args, endindex));
 
-                         consumed = method_dispatch (retval, this->name, first_args.back (), nargout);
+                         consumed = method_dispatch (retval, this->name, first_args.back (), nargout, methods);
                       }
                     else
                       {
@@ -3376,7 +4577,7 @@ namespace coder
                       {
                         first_args.append (convert_to_const_vector( *p_args, endkey));
 
-                        consumed = method_dispatch (retval, this->name, first_args.back (), nargout);
+                        consumed = method_dispatch (retval, this->name, first_args.back (), nargout, methods);
                       }
                     else
                       {
@@ -3407,7 +4608,7 @@ namespace coder
 
                 first_args.append (convert_to_const_vector( *p_args, endkey));
 
-                consumed = method_dispatch (retval, this->name, first_args.back (), nargout);
+                consumed = method_dispatch (retval, this->name, first_args.back (), nargout, methods);
               }
 
             if (consumed)
@@ -3592,6 +4793,51 @@ namespace coder
       }
   }
 
+  // A(i) = x and A(i,j) = x with scalar subscripts inside the bounds of A
+  // and A(end+1) = x. If the subscripts qualify the right hand side is
+  // evaluated and stored in rhs_val even when the element can't be stored in
+  // place, so it isn't evaluated again by the generic assignment.
+
+  bool
+  Index::assign_in_place (const Endindex& endkey, Ptr rhs, octave_value& rhs_val)
+  {
+    if (idx_type[0] != '(' || idx_type[1] != '\0')
+      return false;
+
+    const Ptr_list& args = *arg_list.begin ();
+
+    octave_base_value *val = base->base_value ();
+
+    octave_idx_type linear;
+
+    if (! val || ! (scalar_subscript (val, args, linear)
+                    || append_subscript (val, args)))
+      return false;
+
+    rhs_val = octave_value (rhs->evaluate (1, endkey), false);
+
+    if (rhs_val.is_undefined ())
+      error ("value on right hand side of assignment is undefined");
+
+    if (rhs_val.is_cs_list ())
+      return false;
+
+    // the right hand side may have changed the variable
+
+    val = base->base_value ();
+
+    if (! val)
+      return false;
+
+    if (scalar_subscript (val, args, linear))
+      return assign_element (val, linear, rhs_val);
+
+    if (append_subscript (val, args))
+      return append_element (val, rhs_val);
+
+    return false;
+  }
+
   coder_lvalue
   Index::lvalue (coder_value_list& in_idx)
   {
@@ -3833,7 +5079,12 @@ namespace coder
 
   coder_value double_literal::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
   {
-    return (octave_value(double(val)));
+    return (octave_value(double(val)));
+  }
+
+  coder_value bool_literal::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
+  {
+    return (octave_value(bool(val)));
   }
 
   coder_value int8_literal::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
@@ -3881,6 +5132,141 @@ namespace coder
     return (octave_value(Complex (0.0, val)));
   }
 
+  // Operands of the scalar fast path: real double scalars and logical
+  // scalars.
+
+  enum scalar_operand_kind
+  {
+    sok_none,
+    sok_double,
+    sok_bool
+  };
+
+  static inline scalar_operand_kind
+  scalar_operand (const octave_value& val)
+  {
+    static const int double_id = octave_scalar::static_type_id ();
+
+    static const int bool_id = octave_bool::static_type_id ();
+
+    int id = val.type_id ();
+
+    if (id == double_id)
+      return sok_double;
+
+    if (id == bool_id)
+      return sok_bool;
+
+    return sok_none;
+  }
+
+  static inline double
+  scalar_operand_value (const octave_value& val, scalar_operand_kind kind)
+  {
+    if (kind == sok_double)
+      return static_cast<const octave_scalar&> (val.get_rep ()).octave_scalar::double_value ();
+
+    return static_cast<const octave_bool&> (val.get_rep ()).octave_bool::double_value ();
+  }
+
+  // Stores the result in the storage of a uniquely owned operand of the same
+  // kind as the result, otherwise allocates a new value.
+
+  template <typename T, typename Rep>
+  static inline coder_value
+  scalar_result (T result, scalar_operand_kind kind, octave_value& left, scalar_operand_kind left_kind, octave_value& right, scalar_operand_kind right_kind)
+  {
+    if (left_kind == kind && left.get_count () == 1)
+      {
+        static_cast<octave_base_scalar<T> *> (left.internal_rep ())->scalar_ref () = result;
+
+        return left;
+      }
+
+    if (right_kind == kind && right.get_count () == 1)
+      {
+        static_cast<octave_base_scalar<T> *> (right.internal_rep ())->scalar_ref () = result;
+
+        return right;
+      }
+
+    return coder_value (new Rep (result));
+  }
+
+  static inline bool
+  scalar_binary_op (octave_value::binary_op op, octave_value& left, octave_value& right, coder_value& retval)
+  {
+    scalar_operand_kind left_kind = scalar_operand (left);
+
+    if (left_kind == sok_none)
+      return false;
+
+    scalar_operand_kind right_kind = scalar_operand (right);
+
+    if (right_kind == sok_none)
+      return false;
+
+    double x = scalar_operand_value (left, left_kind);
+
+    double y = scalar_operand_value (right, right_kind);
+
+    double num;
+
+    bool tf;
+
+    switch (op)
+      {
+      case octave_value::op_add:
+        num = x + y;
+        break;
+      case octave_value::op_sub:
+        num = x - y;
+        break;
+      case octave_value::op_mul:
+      case octave_value::op_el_mul:
+        num = x * y;
+        break;
+      case octave_value::op_div:
+      case octave_value::op_el_div:
+        num = x / y;
+        break;
+      case octave_value::op_ldiv:
+      case octave_value::op_el_ldiv:
+        num = y / x;
+        break;
+      case octave_value::op_lt:
+        tf = x < y;
+        retval = scalar_result<bool, octave_bool> (tf, sok_bool, left, left_kind, right, right_kind);
+        return true;
+      case octave_value::op_le:
+        tf = x <= y;
+        retval = scalar_result<bool, octave_bool> (tf, sok_bool, left, left_kind, right, right_kind);
+        return true;
+      case octave_value::op_eq:
+        tf = x == y;
+        retval = scalar_result<bool, octave_bool> (tf, sok_bool, left, left_kind, right, right_kind);
+        return true;
+      case octave_value::op_ge:
+        tf = x >= y;
+        retval = scalar_result<bool, octave_bool> (tf, sok_bool, left, left_kind, right, right_kind);
+        return true;
+      case octave_value::op_gt:
+        tf = x > y;
+        retval = scalar_result<bool, octave_bool> (tf, sok_bool, left, left_kind, right, right_kind);
+        return true;
+      case octave_value::op_ne:
+        tf = x != y;
+        retval = scalar_result<bool, octave_bool> (tf, sok_bool, left, left_kind, right, right_kind);
+        return true;
+      default:
+        return false;
+      }
+
+    retval = scalar_result<double, octave_scalar> (num, sok_double, left, left_kind, right, right_kind);
+
+    return true;
+  }
+
   coder_value
   binary_expr (Ptr a, Ptr b, int nargout, const Endindex& endkey, bool short_circuit, octave_value::binary_op op)
   {
@@ -3888,6 +5274,11 @@ namespace coder
 
     octave_value right ( b->evaluate(nargout,endkey,short_circuit), false);
 
+    coder_value retval;
+
+    if (scalar_binary_op (op, left, right, retval))
+      return retval;
+
     octave::type_info& ti = octave::interpreter::the_interpreter ()->get_type_info ();
 #if OCTAVE_MAJOR_VERSION >= 7
     return (octave::binary_op (ti, op, left, right));
@@ -4298,6 +5689,12 @@ namespace coder
     octave_value val;
     try
       {
+        octave_value rhs_val;
+
+        if (lhs->is_Index ()
+            && static_cast<Index&> (lhs.get ()).assign_in_place (endkey, rhs, rhs_val))
+          return rhs_val;
+
         coder_value_list arg;
 
         coder_lvalue ult = lhs->lvalue (arg);
@@ -4305,7 +5702,8 @@ namespace coder
         if (ult.numel () != 1)
           err_invalid_structure_assignment ();
 
-        octave_value rhs_val ( rhs->evaluate ( 1,endkey), false);
+        if (rhs_val.is_undefined ())
+          rhs_val = octave_value ( rhs->evaluate ( 1,endkey), false);
 
         if (rhs_val.is_undefined ())
           error ("value on right hand side of assignment is undefined");
@@ -4722,14 +6120,16 @@ namespace coder
            name.c_str ());
   }
 
-  coder_value
-  Handle::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
+  // The handles of the functions of the generated code only depend on the
+  // function so each thread creates them once and returns copies
+
+  static octave_value
+  cached_handle (function_maker fm, const char* nm)
   {
-    if (fmaker)
-      {
-        auto fm = fmaker;
-        auto nm = name;
+    octave_value& handle = thread_caches::get ().handles[fm];
 
+    if (handle.is_undefined ())
+      {
         auto * h = new octave_fcn_handle (octave_value (fcn2ov (
               [=](coder_value_list& output, const octave_value_list& args, int nargout)->void
               {
@@ -4741,7 +6141,7 @@ namespace coder
                  fm ().call (output, nargout, args);
               }))
 #if OCTAVE_MAJOR_VERSION < 6
-              , name
+              , nm
 #endif
         );
 #if OCTAVE_MAJOR_VERSION >= 6
@@ -4749,11 +6149,20 @@ namespace coder
 
         std::string & fname = rep.get()->*get(base_fcn_handle_name ());
 
-        fname = name;
+        fname = nm;
 #endif
-        return coder_value(h);
+        handle = octave_value (h);
       }
 
+    return handle;
+  }
+
+  coder_value
+  Handle::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
+  {
+    if (fmaker)
+      return coder_value (cached_handle (fmaker, name));
+
     auto rhs = op_rhs.get ();
 
     octave_base_value * bv = rhs.base_value();
@@ -4869,6 +6278,26 @@ namespace coder
   Anonymous::Anonymous(octave_base_value* arg) : value(new octave_fcn_handle (octave_value(arg, false), "<coderanonymous>")){}
 #endif
 
+  // An anonymous function that doesn't capture variables has one handle per
+  // thread
+
+  static octave_value
+  cached_anonymous (stateless_function fcn)
+  {
+    octave_value& handle = thread_caches::get ().anonymous_handles[fcn];
+
+    if (handle.is_undefined ())
+#if OCTAVE_MAJOR_VERSION >= 6
+      handle = octave_value (new octave_fcn_handle (octave_value(fcn2ov (fcn), false)));
+#else
+      handle = octave_value (new octave_fcn_handle (octave_value(fcn2ov (fcn), false), "<coderanonymous>"));
+#endif
+
+    return handle;
+  }
+
+  Anonymous::Anonymous(stateless_function fcn) : value(cached_anonymous (fcn)){}
+
   coder_value
   Anonymous::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
   {
@@ -4889,17 +6318,135 @@ namespace coder
     return  coder_value(value.val);
   }
 
+  // [a b; c d] of real double scalars with rows of the same length
+
+  static bool
+  concat_scalars (const std::vector<octave_value>& elems, const std::vector<std::size_t>& row_end, octave_value& retval)
+  {
+    static const int scalar_id = octave_scalar::static_type_id ();
+
+    if (row_end.empty () || row_end[0] == 0)
+      return false;
+
+    const std::size_t nr = row_end.size ();
+
+    const std::size_t nc = row_end[0];
+
+    for (std::size_t i = 1; i < nr; i++)
+      if (row_end[i] - row_end[i-1] != nc)
+        return false;
+
+    for (const auto& elem : elems)
+      if (elem.type_id () != scalar_id)
+        return false;
+
+    ::Matrix m (nr, nc);
+
+    for (std::size_t i = 0; i < nr; i++)
+      for (std::size_t j = 0; j < nc; j++)
+        m(i, j) = elems[i * nc + j].double_value ();
+
+    retval = m;
+
+    return true;
+  }
+
+  // [a b c] of real double row vectors and scalars or of character strings
+  // of the same kind
+
+  static bool
+  concat_row (const std::vector<octave_value>& elems, const std::vector<std::size_t>& row_end, octave_value& retval)
+  {
+    static const int scalar_id = octave_scalar::static_type_id ();
+
+    static const int matrix_id = octave_matrix::static_type_id ();
+
+    static const int str_id = octave_char_matrix_str::static_type_id ();
+
+    static const int sq_str_id = octave_char_matrix_sq_str::static_type_id ();
+
+    if (row_end.size () != 1 || elems.empty ())
+      return false;
+
+    const int type = elems[0].type_id () == scalar_id ? matrix_id : elems[0].type_id ();
+
+    if (type != matrix_id && type != str_id && type != sq_str_id)
+      return false;
+
+    octave_idx_type len = 0;
+
+    for (const auto& elem : elems)
+      {
+        const int id = elem.type_id ();
+
+        if (type == matrix_id && id == scalar_id)
+          {
+            len++;
+
+            continue;
+          }
+
+        if (id != type || elem.ndims () != 2 || elem.rows () != 1)
+          return false;
+
+        len += elem.columns ();
+      }
+
+    if (elems.size () == 1)
+      {
+        retval = elems[0];
+
+        return true;
+      }
+
+    if (type == matrix_id)
+      {
+        ::Matrix m (1, len);
+
+        double *dest = m.fortran_vec ();
+
+        for (const auto& elem : elems)
+          {
+            if (elem.type_id () == scalar_id)
+              *dest++ = elem.double_value ();
+            else
+              {
+                NDArray a = elem.array_value ();
+
+                dest = std::copy_n (a.data (), a.numel (), dest);
+              }
+          }
+
+        retval = m;
+      }
+    else
+      {
+        std::string str;
+
+        str.reserve (len);
+
+        for (const auto& elem : elems)
+          str += elem.string_value ();
+
+        retval = octave_value (str, type == sq_str_id ? '\'' : '"');
+      }
+
+    return true;
+  }
+
   coder_value
   Matrixc::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
   {
-    octave_value_list rows(mat.size());
+    // the elements of all rows and the end of each row in the elements
 
-    octave_idx_type i = 0;
+    std::vector<octave_value> elems;
+
+    std::vector<std::size_t> row_end;
+
+    row_end.reserve (mat.size ());
 
     for (auto& row : mat)
       {
-        std::vector<octave_value> current_row;
-
         for (auto& col : row)
           {
             octave_value tmp ( col->evaluate(1,endkey), false);
@@ -4921,20 +6468,40 @@ namespace coder
                         if (list_val.is_undefined ())
                           continue;
 
-                        current_row.push_back(list_val);
+                        elems.push_back(list_val);
                       }
                   }
                 else
-                  current_row.push_back(tmp);
+                  elems.push_back(tmp);
               }
           }
 
-        if (current_row.empty ())
-          current_row.push_back (::Matrix());
+        row_end.push_back (elems.size ());
+      }
+
+    octave_value val;
+
+    if (concat_scalars (elems, row_end, val) || concat_row (elems, row_end, val))
+      return val;
+
+    octave_value_list rows(row_end.size ());
+
+    std::size_t begin = 0;
+
+    for (std::size_t i = 0; i < row_end.size (); i++)
+      {
+        octave_value_list current_row;
+
+        if (begin == row_end[i])
+          current_row.append (::Matrix());
+        else
+          current_row = octave_value_list (std::vector<octave_value> (elems.begin () + begin, elems.begin () + row_end[i]));
+
+        begin = row_end[i];
 
-        auto hcat = OCTAVE_DEPR_NS Fhorzcat(octave_value_list(current_row),1);
+        auto hcat = OCTAVE_DEPR_NS Fhorzcat(current_row,1);
 
-        rows(i++) = hcat.empty()? octave_value(::Matrix()) : hcat(0);
+        rows(i) = hcat.empty()? octave_value(::Matrix()) : hcat(0);
       }
 
     octave_value_list retval = OCTAVE_DEPR_NS Fvertcat(rows,1);
@@ -4945,6 +6512,20 @@ namespace coder
     return  (retval(0));
   }
 
+  coder_value
+  ScalarMatrix::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
+  {
+    ::Matrix m (rows, cols);
+
+    auto p = elems.begin ();
+
+    for (octave_idx_type i = 0; i < rows; i++)
+      for (octave_idx_type j = 0; j < cols; j++)
+        m(i, j) = *p++;
+
+    return octave_value (m);
+  }
+
   coder_value
   Cellc::evaluate( int nargout, const Endindex& endkey, bool short_circuit)
   {
@@ -5008,6 +6589,102 @@ namespace coder
     return  coder_value(val.val);
   }
 
+  class switch_table_rep
+  {
+  public:
+
+    switch_table_rep (std::initializer_list<string_case> strings, std::initializer_list<std::pair<double, int>> numbers)
+    {
+      // single characters are compared to numbers by their code
+
+      for (const auto& str : strings)
+        if (str.len == 1)
+          insert (m_numbers, static_cast<unsigned char> (str.str[0]), str.index);
+        else
+          insert (m_strings, std::string (str.str, str.len), str.index);
+
+      for (const auto& num : numbers)
+        insert (m_numbers, static_cast<long long> (num.first), num.second);
+    }
+
+    int find (const octave_value& val) const
+    {
+      if (val.is_string ())
+        {
+          if (val.rows () != 1 || val.columns () < 1)
+            return -2;
+
+          std::string str = val.string_value ();
+
+          if (str.length () == 1)
+            return find_number (static_cast<unsigned char> (str[0]));
+
+          auto it = m_strings.find (str);
+
+          return it == m_strings.end () ? -1 : it->second;
+        }
+
+      if (val.is_scalar_type () && val.isreal () && (val.isnumeric () || val.islogical ()))
+        {
+          double d = val.double_value ();
+
+          if (d != std::trunc (d) || std::abs (d) > 9007199254740992.0)
+            return -1;
+
+          return find_number (static_cast<long long> (d));
+        }
+
+      return -2;
+    }
+
+  private:
+
+    // the first case that has a label wins
+
+    template <typename Map, typename Key>
+    static void insert (Map& map, const Key& key, int index)
+    {
+      auto it = map.emplace (key, index).first;
+
+      it->second = std::min (it->second, index);
+    }
+
+    int find_number (long long key) const
+    {
+      auto it = m_numbers.find (key);
+
+      return it == m_numbers.end () ? -1 : it->second;
+    }
+
+    std::unordered_map<std::string, int> m_strings;
+
+    std::unordered_map<long long, int> m_numbers;
+  };
+
+  switch_table::switch_table (std::initializer_list<string_case> strings, std::initializer_list<std::pair<double, int>> numbers)
+  : rep (new switch_table_rep (strings, numbers))
+  {}
+
+  switch_table::~switch_table ()
+  {
+    delete rep;
+  }
+
+  int
+  switch_table::find (const octave_value& val) const
+  {
+    return rep->find (val);
+  }
+
+  Switch::Switch(Ptr expr, const switch_table& table)
+  : val(expr->evaluate(1)), match(-2)
+  {
+    octave_value tmp (val.val, true);
+
+    if (tmp.is_defined ())
+      match = table.find (tmp);
+  }
+
   bool
   Switch::operator()(Ptr label)
   {
@@ -5508,8 +7185,90 @@ namespace coder
 
         retval = octave_value (r);
       }
-    else
-      err_wrong_type_arg ("isargout", arg (0));
+    else
+      err_wrong_type_arg ("isargout", arg (0));
+  }
+
+  octave_base_value* narginchk_function (int nargin, coder_value_list&)
+  {
+    return fcn2ov (
+      [nargin](coder_value_list& output, const octave_value_list& arg, int nout)->void
+      {
+        return call_narginchk (output, nargin, arg);
+      });
+  }
+
+  octave_base_value* nargoutchk_function (int nargout, coder_value_list&)
+  {
+    return fcn2ov (
+      [nargout](coder_value_list& output, const octave_value_list& arg, int nout)->void
+      {
+        return call_nargoutchk (output, nargout, arg, nout);
+      });
+  }
+
+  octave_base_value* nargin_function (int nargin, coder_value_list&)
+  {
+    return fcn2ov (
+      [nargin](coder_value_list& output, const octave_value_list& arg, int nout)->void
+      {
+        return call_nargin (output, nargin, arg, nout);
+      });
+  }
+
+  octave_base_value* nargout_function (int nargout, coder_value_list&)
+  {
+    return fcn2ov (
+      [nargout](coder_value_list& output, const octave_value_list& arg, int nout)->void
+      {
+        return call_nargout (output, nargout, arg, nout);
+      });
+  }
+
+  octave_base_value* isargout_function (int nargout, coder_value_list& output)
+  {
+    return fcn2ov (
+      [nargout, &output](coder_value_list& out, const octave_value_list& arg, int nout)->void
+      {
+        return call_isargout (out, nargout, output, arg, nout);
+      });
+  }
+
+  Symbol&
+  Narg_function::function ()
+  {
+    if (! fcn.is_defined ())
+      fcn = Symbol (make (count, output));
+
+    return fcn;
+  }
+
+  coder_value
+  Narg::evaluate(int nargout, const Endindex& endkey, bool short_circuit)
+  {
+    if (sym.is_defined())
+      return sym.evaluate(nargout, endkey, short_circuit);
+
+    if (fun.is_count)
+      return coder_value (octave_value (double (fun.count)));
+
+    return fun.function ().evaluate(nargout, endkey, short_circuit);
+  }
+
+  void
+  Narg::evaluate_n(coder_value_list& output, int nargout, const Endindex& endkey, bool short_circuit)
+  {
+    if (sym.is_defined())
+      return sym.evaluate_n(output, nargout, endkey, short_circuit);
+
+    if (fun.is_count)
+      {
+        output.append (octave_value (double (fun.count)));
+
+        return;
+      }
+
+    return fun.function ().evaluate_n(output, nargout, endkey, short_circuit);
   }
 
   void call_feval (coder_value_list& output, const octave_value_list& args, int nargout)
@@ -5642,7 +7401,11 @@ namespace coder
   {
   public:
     for_loop_rep (Ptr lhs, Ptr expr, bool fast_loop):
-      val (expr->evaluate (1), false),
+      for_loop_rep (lhs, octave_value (expr->evaluate (1), false), fast_loop)
+    {}
+
+    for_loop_rep (Ptr lhs, const octave_value& range, bool fast_loop):
+      val (range),
       looptype (
         val.is_range () ? range_loop
       : val.is_scalar_type () ? scalar_loop
@@ -5938,6 +7701,10 @@ namespace coder
   : rep (new for_loop_rep(lhs, expr, fast_loop))
   {}
 
+  for_loop::for_loop (Ptr lhs, const colon_range& range, bool fast_loop)
+  : rep (new for_loop_rep(lhs, octave_value (range.value (), true), fast_loop))
+  {}
+
   for_iterator for_loop::begin()  { return rep->begin (); }
 
   for_iterator for_loop::end()  { return rep->end (); }
@@ -5947,6 +7714,473 @@ namespace coder
     delete rep;
   }
 
+  scalar_range::scalar_range (double base, double limit)
+  : scalar_range (base, 1.0, limit)
+  {}
+
+  scalar_range::scalar_range (double base, double increment, double limit)
+  : m_base (base), m_increment (increment), m_final (base), m_numel (0)
+  {
+#if OCTAVE_MAJOR_VERSION >= 7
+    octave_value val = octave::colon_op (octave_value (base), octave_value (increment), octave_value (limit), true);
+#else
+    octave_value val = ::do_colon_op (octave_value (base), octave_value (increment), octave_value (limit), true);
+#endif
+
+    if (val.is_range ())
+      {
+        OCTAVE_RANGE rng = val.range_value ();
+
+        m_numel = rng.numel ();
+
+        if (m_numel > 0)
+          {
+            m_base = rng.elem (0);
+
+            m_final = rng.elem (m_numel - 1);
+          }
+      }
+    else
+      {
+        NDArray arr = val.array_value ();
+
+        m_numel = arr.numel ();
+
+        if (m_numel > 0)
+          {
+            m_base = arr (0);
+
+            m_final = arr (m_numel - 1);
+          }
+      }
+  }
+
+  colon_range::colon_range (Ptr base, Ptr limit)
+  : colon_range (base, Ptr (), limit)
+  {}
+
+  colon_range::colon_range (Ptr base, Ptr increment, Ptr limit)
+  : m_range (), m_value (), m_is_scalar (false)
+  {
+    octave_value ov_base (base->evaluate (1), false);
+
+    octave_value ov_increment (increment.is_valid () ?
+      octave_value (increment->evaluate (1), false) :
+      octave_value (1.0));
+
+    octave_value ov_limit (limit->evaluate (1), false);
+
+    auto is_double_scalar = [](const octave_value& val)
+    {
+      return val.is_real_scalar () && val.is_double_type ();
+    };
+
+    if (is_double_scalar (ov_base) && is_double_scalar (ov_increment)
+        && is_double_scalar (ov_limit))
+      {
+        m_range = scalar_range (ov_base.double_value (),
+                                ov_increment.double_value (),
+                                ov_limit.double_value ());
+
+        m_is_scalar = true;
+      }
+    else
+#if OCTAVE_MAJOR_VERSION >= 7
+      m_value = coder_value (octave::colon_op (ov_base, ov_increment, ov_limit, true));
+#else
+      m_value = coder_value (::do_colon_op (ov_base, ov_increment, ov_limit, true));
+#endif
+  }
+
+  static std::recursive_mutex& interpreter_mutex ()
+  {
+    static std::recursive_mutex mutex;
+
+    return mutex;
+  }
+
+  interpreter_lock::interpreter_lock ()
+  : m_locked (false)
+  {
+    lock ();
+  }
+
+  interpreter_lock::~interpreter_lock ()
+  {
+    unlock ();
+  }
+
+  void interpreter_lock::lock ()
+  {
+    if (! m_locked)
+      {
+        interpreter_mutex ().lock ();
+
+        m_locked = true;
+      }
+  }
+
+  void interpreter_lock::unlock ()
+  {
+    if (m_locked)
+      {
+        interpreter_mutex ().unlock ();
+
+        m_locked = false;
+      }
+  }
+
+  // true in the threads while they run the chunks of a parfor loop. A
+  // parfor loop that is executed by one of its chunks runs serially.
+
+  static thread_local bool in_parfor_loop = false;
+
+  // Worker threads of the parfor loops. The chunks of a loop are handed out
+  // by an atomic counter so a thread that finishes its chunk early takes the
+  // next one. The calling thread also runs chunks.
+
+  class parfor_pool
+  {
+  public:
+
+    static parfor_pool& instance ()
+    {
+      static parfor_pool pool;
+
+      return pool;
+    }
+
+    int size () const
+    {
+      return m_threads.size () + 1;
+    }
+
+    void run (int nthreads, octave_idx_type nchunks, const std::function<void(octave_idx_type)>& task)
+    {
+      int helpers = std::min<octave_idx_type> (std::min (nthreads, size ()), nchunks) - 1;
+
+      {
+        std::lock_guard<std::mutex> guard (m_mutex);
+
+        m_task = &task;
+
+        m_next = 0;
+
+        m_failed = false;
+
+        m_nchunks = nchunks;
+
+        m_active = std::max (helpers, 0);
+
+        m_busy = m_active;
+
+        m_error = nullptr;
+
+        if (m_active > 0)
+          m_generation++;
+      }
+
+      if (m_active > 0)
+        m_start.notify_all ();
+
+      execute ();
+
+      {
+        std::unique_lock<std::mutex> guard (m_mutex);
+
+        m_done.wait (guard, [this] { return m_busy == 0; });
+      }
+
+      if (m_error)
+        {
+          std::exception_ptr err = m_error;
+
+          m_error = nullptr;
+
+          std::rethrow_exception (err);
+        }
+    }
+
+    ~parfor_pool ()
+    {
+      {
+        std::lock_guard<std::mutex> guard (m_mutex);
+
+        m_stop = true;
+      }
+
+      m_start.notify_all ();
+
+      for (auto& t : m_threads)
+        t.join ();
+    }
+
+  private:
+
+    parfor_pool ()
+    : m_threads (), m_mutex (), m_start (), m_done (), m_task (nullptr),
+      m_next (0), m_failed (false), m_nchunks (0), m_active (0), m_busy (0),
+      m_generation (0), m_stop (false), m_error ()
+    {
+      // the registry of the caches outlives the threads that use it
+
+      thread_caches::get ();
+
+      int n = std::thread::hardware_concurrency ();
+
+      for (int i = 0; i < n - 1; i++)
+        m_threads.emplace_back (&parfor_pool::work, this, i);
+    }
+
+    void work (int id)
+    {
+      unsigned long generation = 0;
+
+      while (true)
+        {
+          {
+            std::unique_lock<std::mutex> guard (m_mutex);
+
+            m_start.wait (guard, [&] { return m_stop || m_generation != generation; });
+
+            if (m_stop)
+              {
+                thread_caches::release ();
+
+                return;
+              }
+
+            generation = m_generation;
+
+            if (id >= m_active)
+              continue;
+          }
+
+          execute ();
+
+          std::lock_guard<std::mutex> guard (m_mutex);
+
+          if (--m_busy == 0)
+            m_done.notify_all ();
+        }
+    }
+
+    void execute ()
+    {
+      bool outer = in_parfor_loop;
+
+      in_parfor_loop = true;
+
+      octave_idx_type i;
+
+      while (! m_failed && (i = m_next++) < m_nchunks)
+        {
+          try
+            {
+              (*m_task) (i);
+            }
+          catch (...)
+            {
+              std::lock_guard<std::mutex> guard (m_mutex);
+
+              if (! m_error)
+                m_error = std::current_exception ();
+
+              m_failed = true;
+            }
+        }
+
+      in_parfor_loop = outer;
+    }
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_start;
+
+    std::condition_variable m_done;
+
+    const std::function<void(octave_idx_type)> *m_task;
+
+    std::atomic<octave_idx_type> m_next;
+
+    std::atomic<bool> m_failed;
+
+    octave_idx_type m_nchunks;
+
+    int m_active;
+
+    int m_busy;
+
+    unsigned long m_generation;
+
+    bool m_stop;
+
+    std::exception_ptr m_error;
+  };
+
+  // number of chunks of a parfor loop with enough iterations
+
+  static const octave_idx_type parfor_chunk_count = 256;
+
+  class parfor_loop_rep
+  {
+  public:
+
+    parfor_loop_rep (octave_idx_type numel, Ptr maxproc)
+    : m_val (), m_is_scalar (false), m_nrows (1), m_numel (numel),
+      m_nthreads (1), m_nchunks (0)
+    {
+      init (maxproc);
+    }
+
+    parfor_loop_rep (Ptr expr, Ptr maxproc)
+    : m_val (expr->evaluate (1), false), m_is_scalar (false), m_nrows (1),
+      m_numel (0), m_nthreads (1), m_nchunks (0)
+    {
+      if (m_val.is_scalar_type ())
+        {
+          m_is_scalar = true;
+
+          m_numel = 1;
+        }
+      else if (m_val.is_range () || m_val.is_matrix_type () || m_val.iscell ()
+               || m_val.is_string () || m_val.isstruct ())
+        {
+          dim_vector dv = m_val.dims ().redim (2);
+
+          if (m_val.ndims () > 2)
+            m_val = m_val.reshape (dv);
+
+          m_nrows = dv(0);
+
+          m_numel = m_nrows > 0 ? dv(1) : 0;
+        }
+      else
+        error ("invalid type in for loop expression");
+
+      init (maxproc);
+    }
+
+    octave_idx_type chunks () const
+    {
+      return m_nchunks;
+    }
+
+    void set_loop_val (Symbol& var, octave_idx_type i) const
+    {
+      interpreter_lock lock;
+
+      octave_value val = m_val;
+
+      if (! m_is_scalar)
+        {
+          octave_value_list idx (m_nrows == 1 ? 1 : 2);
+
+          if (m_nrows != 1)
+            idx(0) = octave_value::magic_colon_t;
+
+          idx(idx.length () - 1) = double (i + 1);
+#if OCTAVE_MAJOR_VERSION >= 7
+          val = val.index_op (idx);
+#else
+          val = val.do_index_op (idx);
+#endif
+        }
+
+      coder_value_list lst;
+
+      coder_lvalue ult = var.lvalue (lst);
+
+      ult.assign (octave_value::op_asn_eq, val, lst);
+    }
+
+    void run (const std::function<void(const parfor_chunk&)>& body)
+    {
+      auto task = [&] (octave_idx_type c)
+      {
+        octave_idx_type first = m_numel * c / m_nchunks;
+
+        octave_idx_type last = m_numel * (c + 1) / m_nchunks;
+
+        body (parfor_chunk (this, c, first, last, m_numel));
+      };
+
+      if (m_nthreads == 1)
+        {
+          for (octave_idx_type c = 0; c < m_nchunks; c++)
+            task (c);
+        }
+      else
+        parfor_pool::instance ().run (m_nthreads, m_nchunks, task);
+    }
+
+  private:
+
+    void init (Ptr maxproc)
+    {
+      m_nthreads = in_parfor_loop ? 1 : parfor_pool::instance ().size ();
+
+      if (maxproc.is_valid ())
+        {
+          octave_value val (maxproc->evaluate (1), false);
+
+          double n = val.double_value ();
+
+          if (n < m_nthreads)
+            m_nthreads = n < 1 ? 1 : int (n);
+        }
+
+      // The iterations are split into the same chunks regardless of the
+      // number of threads so the partial results of the reductions and the
+      // order that they are combined in don't depend on the machine. Many
+      // chunks per thread also balance iterations of different cost.
+
+      m_nchunks = std::min<octave_idx_type> (m_numel, parfor_chunk_count);
+    }
+
+    octave_value m_val;
+
+    bool m_is_scalar;
+
+    octave_idx_type m_nrows;
+
+    octave_idx_type m_numel;
+
+    int m_nthreads;
+
+    octave_idx_type m_nchunks;
+  };
+
+  void parfor_chunk::set_loop_val (Symbol& var, octave_idx_type i) const
+  {
+    m_loop->set_loop_val (var, i);
+  }
+
+  parfor_loop::parfor_loop (octave_idx_type numel, Ptr maxproc)
+  : rep (new parfor_loop_rep (numel, maxproc))
+  {}
+
+  parfor_loop::parfor_loop (Ptr expr, Ptr maxproc)
+  : rep (new parfor_loop_rep (expr, maxproc))
+  {}
+
+  octave_idx_type parfor_loop::chunks () const
+  {
+    return rep->chunks ();
+  }
+
+  void parfor_loop::run (const std::function<void(const parfor_chunk&)>& body)
+  {
+    rep->run (body);
+  }
+
+  parfor_loop::~parfor_loop ()
+  {
+    delete rep;
+  }
+
   struct_loop::struct_loop (Ptr v, Ptr k, Ptr expr)
   : rep (new struct_loop_rep(v, k, expr))
   {}
@@ -241,6 +241,19 @@ namespace coder_compiler
     return result;
   }
 
+  std::set<coder_symbol_ptr, symscope::compare_symbol>
+  symscope::free_symbols () const
+  {
+    auto result = m_symbols.at((int)symbol_type::inherited);
+
+    for(auto& sc: anon_fcn_scopes)
+      for(auto& sym: sc->free_symbols())
+        if (! contains(sym))
+          result.insert(sym);
+
+    return result;
+  }
+
   const std::vector <
     std::set<coder_symbol_ptr, symscope::compare_symbol>
     >& symscope::symbols () const
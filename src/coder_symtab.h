@@ -136,6 +136,12 @@ namespace coder_compiler
     std::vector<std::deque<symscope_ptr> >
     traverse(std::vector<std::deque<symscope_ptr>> result) const;
 
+    // The symbols of the parent scopes that the scope and its anonymous
+    // functions refer to
+
+    std::set<coder_symbol_ptr, compare_symbol>
+    free_symbols () const;
+
     const std::vector <
       std::set<coder_symbol_ptr, symscope::compare_symbol>
       >&
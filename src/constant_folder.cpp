@@ -0,0 +1,216 @@
+#include <octave/interpreter.h>
+#include <octave/oct.h>
+#include <octave/parse.h>
+#include <octave/version.h>
+
+#include "constant_folder.h"
+
+namespace coder_compiler
+{
+  bool
+  constant_folder::fold (octave::tree_expression *expr, octave_value& val)
+  {
+    if (! expr)
+      return false;
+
+    auto it = m_values.find (expr);
+
+    if (it == m_values.end ())
+      {
+        octave_value result;
+
+        try
+          {
+            if (! evaluate (expr, result))
+              result = octave_value ();
+          }
+        catch (const octave::execution_exception&)
+          {
+#if OCTAVE_MAJOR_VERSION >= 6
+            octave::interpreter::the_interpreter ()-> recover_from_exception ();
+#else
+            octave::interpreter::recover_from_exception ();
+#endif
+            result = octave_value ();
+          }
+
+        it = m_values.emplace (expr, result).first;
+      }
+
+    if (it->second.is_undefined ())
+      return false;
+
+    val = it->second;
+
+    return true;
+  }
+
+  bool
+  constant_folder::evaluate (octave::tree_expression *expr, octave_value& val)
+  {
+    if (! expr)
+      return false;
+
+    octave::type_info& ti = octave::interpreter::the_interpreter ()->get_type_info ();
+
+    if (expr->is_constant ())
+      {
+        val = static_cast<octave::tree_constant *> (expr)->value ();
+
+        return val.is_defined () && ! val.is_magic_colon ();
+      }
+
+    if (expr->is_identifier ())
+      {
+        if (! m_functions.count (expr->name ()))
+          return false;
+
+        octave_value_list ret = octave::feval (expr->name (), octave_value_list (), 1);
+
+        if (ret.empty ())
+          return false;
+
+        val = ret(0);
+
+        return val.is_defined ();
+      }
+
+    if (dynamic_cast<octave::tree_cell *> (expr))
+      return false;
+
+    if (auto mat = dynamic_cast<octave::tree_matrix *> (expr))
+      return evaluate_matrix (*mat, val);
+
+    if (auto pre = dynamic_cast<octave::tree_prefix_expression *> (expr))
+      {
+        octave_value::unary_op op = pre->op_type ();
+
+        if (op != octave_value::op_not && op != octave_value::op_uplus
+            && op != octave_value::op_uminus)
+          return false;
+
+        octave_value operand;
+
+        if (! evaluate (pre->operand (), operand))
+          return false;
+#if OCTAVE_MAJOR_VERSION >= 7
+        val = octave::unary_op (ti, op, operand);
+#else
+        val = ::do_unary_op (ti, op, operand);
+#endif
+        return val.is_defined ();
+      }
+
+    if (auto post = dynamic_cast<octave::tree_postfix_expression *> (expr))
+      {
+        octave_value::unary_op op = post->op_type ();
+
+        if (op != octave_value::op_transpose && op != octave_value::op_hermitian)
+          return false;
+
+        octave_value operand;
+
+        if (! evaluate (post->operand (), operand))
+          return false;
+#if OCTAVE_MAJOR_VERSION >= 7
+        val = octave::unary_op (ti, op, operand);
+#else
+        val = ::do_unary_op (ti, op, operand);
+#endif
+        return val.is_defined ();
+      }
+
+    // short-circuit operators are left to the runtime
+
+    if (dynamic_cast<octave::tree_boolean_expression *> (expr))
+      return false;
+
+    // a compound binary expression is evaluated like the binary expression
+    // of its operands
+
+    if (auto bin = dynamic_cast<octave::tree_binary_expression *> (expr))
+      {
+        octave_value::binary_op op = bin->op_type ();
+
+        if (op == octave_value::op_struct_ref)
+          return false;
+
+        octave_value lhs;
+
+        octave_value rhs;
+
+        if (! evaluate (bin->lhs (), lhs) || ! evaluate (bin->rhs (), rhs))
+          return false;
+
+        // the matrix division and power warn about singular matrices
+
+        if ((op == octave_value::op_div || op == octave_value::op_ldiv
+             || op == octave_value::op_pow)
+            && (lhs.numel () != 1 || rhs.numel () != 1))
+          return false;
+#if OCTAVE_MAJOR_VERSION >= 7
+        val = octave::binary_op (ti, op, lhs, rhs);
+#else
+        val = ::do_binary_op (ti, op, lhs, rhs);
+#endif
+        return val.is_defined ();
+      }
+
+    return false;
+  }
+
+  bool
+  constant_folder::evaluate_matrix (octave::tree_matrix& mat, octave_value& val)
+  {
+    octave_value_list rows;
+
+    bool has_char = false;
+
+    bool has_other = false;
+
+    for (octave::tree_argument_list *row : mat)
+      {
+        if (! row)
+          continue;
+
+        octave_value_list elems;
+
+        for (octave::tree_expression *elt : *row)
+          {
+            octave_value elem;
+
+            if (! evaluate (elt, elem) || elem.is_cs_list ())
+              return false;
+
+            // concatenation of characters and numbers warns about the
+            // implicit conversion
+
+            if (elem.is_string ())
+              has_char = true;
+            else
+              has_other = true;
+
+            elems.append (elem);
+          }
+
+        if (has_char && has_other)
+          return false;
+
+        if (elems.empty ())
+          elems.append (Matrix ());
+
+        octave_value_list hcat = octave::feval ("horzcat", elems, 1);
+
+        rows.append (hcat.empty () ? octave_value (Matrix ()) : hcat(0));
+      }
+
+    if (rows.empty ())
+      return false;
+
+    octave_value_list vcat = octave::feval ("vertcat", rows, 1);
+
+    val = vcat.empty () ? octave_value (Matrix ()) : vcat(0);
+
+    return val.is_defined ();
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+
+#include <octave/pt-all.h>
+
+class octave_value;
+
+namespace coder_compiler
+{
+  // Evaluates the expressions that only consist of constants, of builtin
+  // constant functions like pi and of operators at translation time.
+  // Operators that may issue a warning, like the division by a singular
+  // matrix or the concatenation of numbers and characters, aren't folded
+  // and an expression whose evaluation is an error is left to the runtime.
+
+  class constant_folder
+  {
+  public:
+
+    constant_folder ()
+    : m_values (), m_functions ()
+    {}
+
+    // The builtin functions that can't be shadowed by a variable of the
+    // function that is translated
+
+    void
+    set_functions (const std::set<std::string>& names)
+    {
+      m_functions = names;
+
+      m_values.clear ();
+    }
+
+    bool
+    fold (octave::tree_expression *expr, octave_value& val);
+
+  private:
+
+    bool
+    evaluate (octave::tree_expression *expr, octave_value& val);
+
+    bool
+    evaluate_matrix (octave::tree_matrix& mat, octave_value& val);
+
+    std::map<octave::tree_expression *, octave_value> m_values;
+
+    std::set<std::string> m_functions;
+  };
+}
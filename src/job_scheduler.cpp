@@ -0,0 +1,365 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <octave/builtin-defun-decls.h>
+#include <octave/file-ops.h>
+#include <octave/file-stat.h>
+#include <octave/oct.h>
+#include <octave/pager.h>
+#include <octave/parse.h>
+#include <octave/quit.h>
+#include <octave/version.h>
+
+#include "job_scheduler.h"
+
+#if OCTAVE_MAJOR_VERSION >= 7
+  #define OCTAVE_DEPR_NS octave::
+#else
+  #define OCTAVE_DEPR_NS ::
+#endif
+
+namespace coder_compiler
+{
+  // path of the executable that is called by mkoctfile.m
+
+  static std::string
+  mkoctfile_executable ()
+  {
+    using octave::sys::file_ops::concat;
+
+    std::string bindir = OCTAVE_DEPR_NS F__octave_config_info__ (octave_value("bindir"),1)(0).string_value ();
+
+    std::string ext = OCTAVE_DEPR_NS F__octave_config_info__ (octave_value("EXEEXT"),1)(0).string_value ();
+
+    std::string exe = concat (bindir, "mkoctfile-" OCTAVE_VERSION + ext);
+
+    octave::sys::file_stat fs (exe);
+
+    if (! fs.exists ())
+      exe = concat (bindir, "mkoctfile" + ext);
+
+    return exe;
+  }
+
+  // Same quoting as mkoctfile.m so that the arguments that are prepared for
+  // the serial build can also be used here.
+
+  static std::string
+  make_command_line (const std::string& exe, const build_job::command& args)
+  {
+    std::string cmd = "\"" + exe + "\"";
+
+    for (const auto& arg : args)
+      cmd += " \"" + arg + "\"";
+
+    cmd += " 2>&1";
+
+#if defined (_WIN32)
+    cmd = "\"" + cmd + "\"";
+#endif
+
+    return cmd;
+  }
+
+  static int
+  execute_command (const std::string& cmd, std::string& output)
+  {
+#if defined (_WIN32)
+    FILE *fp = _popen (cmd.c_str (), "r");
+#else
+    FILE *fp = popen (cmd.c_str (), "r");
+#endif
+
+    if (! fp)
+      return -1;
+
+    char buf[4096];
+
+    size_t n;
+
+    while ((n = fread (buf, 1, sizeof (buf), fp)) > 0)
+      output.append (buf, n);
+
+#if defined (_WIN32)
+    return _pclose (fp);
+#else
+    return pclose (fp);
+#endif
+  }
+
+  job_scheduler::job_scheduler (int max_jobs, bool verbose)
+  :
+    jobs(),
+    max_jobs(max_jobs),
+    verbose(verbose)
+  {}
+
+  size_t
+  job_scheduler::add_job (
+    const std::string& description,
+    std::vector<build_job::command> commands,
+    std::vector<size_t> deps,
+    bool shared_link
+  )
+  {
+    size_t id = jobs.size ();
+
+    for (size_t d : deps)
+      if (d >= id)
+        error ("coder: invalid dependency of build job \"%s\"", description.c_str ());
+
+    jobs.push_back ({description, std::move (commands), std::move (deps), shared_link});
+
+    return id;
+  }
+
+  void
+  job_scheduler::run ()
+  {
+    if (jobs.empty ())
+      return;
+
+    if (max_jobs > 1 && jobs.size () > 1)
+      run_parallel ();
+    else
+      run_serial ();
+
+    jobs.clear ();
+  }
+
+  void
+  job_scheduler::run_serial ()
+  {
+    std::string  DL_LDFLAGS = OCTAVE_DEPR_NS F__octave_config_info__ (octave_value("DL_LDFLAGS"),1)(0).string_value ();
+
+    std::string  SH_LDFLAGS = OCTAVE_DEPR_NS F__octave_config_info__ (octave_value("SH_LDFLAGS"),1)(0).string_value ();
+
+    size_t n = jobs.size ();
+
+    size_t i = 0;
+
+    // jobs are added after their dependencies so the insertion order is a
+    // valid order of execution
+
+    for (const auto& job : jobs)
+      {
+        if (verbose)
+          octave_stdout << "  [" << ++i << "/" << n << "] " << job.description << "\n";
+
+        if (job.shared_link)
+          OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(SH_LDFLAGS) ));
+
+        try
+          {
+            for (const auto& cmd : job.commands)
+              {
+                octave_value_list args;
+
+                for (const auto& arg : cmd)
+                  args.append (octave_value (arg));
+
+                octave_value_list ret = octave::feval ("mkoctfile", args, 2);
+
+                if (ret(1).int_value () != 0)
+                  error ("coder: compile error");
+              }
+          }
+        catch (...)
+          {
+            if (job.shared_link)
+              OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(DL_LDFLAGS)));
+
+            throw;
+          }
+
+        if (job.shared_link)
+          OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(DL_LDFLAGS)));
+      }
+  }
+
+  void
+  job_scheduler::run_parallel ()
+  {
+    struct job_result
+    {
+      size_t id;
+
+      int status;
+
+      std::string output;
+    };
+
+    // The interpreter isn't thread safe so the worker threads only spawn the
+    // compiler processes. Scheduling and printing are done by this thread.
+
+    std::string exe = mkoctfile_executable ();
+
+    std::string  DL_LDFLAGS = OCTAVE_DEPR_NS F__octave_config_info__ (octave_value("DL_LDFLAGS"),1)(0).string_value ();
+
+    std::string  SH_LDFLAGS = OCTAVE_DEPR_NS F__octave_config_info__ (octave_value("SH_LDFLAGS"),1)(0).string_value ();
+
+    size_t n = jobs.size ();
+
+    std::vector<size_t> num_deps (n);
+
+    std::vector<std::vector<size_t>> dependents (n);
+
+    std::vector<std::vector<std::string>> command_lines (n);
+
+    std::deque<size_t> ready;
+
+    bool shared_link = false;
+
+    for (size_t i = 0; i < n; i++)
+      {
+        num_deps[i] = jobs[i].deps.size ();
+
+        for (size_t d : jobs[i].deps)
+          dependents[d].push_back (i);
+
+        for (const auto& cmd : jobs[i].commands)
+          command_lines[i].push_back (make_command_line (exe, cmd));
+
+        if (num_deps[i] == 0)
+          ready.push_back (i);
+
+        shared_link = shared_link || jobs[i].shared_link;
+      }
+
+    std::mutex mtx;
+
+    std::condition_variable cv;
+
+    std::deque<job_result> finished;
+
+    std::vector<std::thread> workers (n);
+
+    // compile commands ignore DL_LDFLAGS so it is set once for all jobs
+
+    struct unwind
+    {
+      unwind (std::vector<std::thread>& workers, bool reset, const std::string& flags)
+      : m_workers (workers), m_reset (reset), m_flags (flags)
+      {}
+
+      ~unwind ()
+      {
+        for (auto& w : m_workers)
+          if (w.joinable ())
+            w.join ();
+
+        if (m_reset)
+          OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(m_flags)));
+      }
+
+      std::vector<std::thread>& m_workers;
+
+      bool m_reset;
+
+      std::string m_flags;
+    };
+
+    if (shared_link)
+      OCTAVE_DEPR_NS Fsetenv (ovl(octave_value("DL_LDFLAGS"), octave_value(SH_LDFLAGS) ));
+
+    unwind unw (workers, shared_link, DL_LDFLAGS);
+
+    auto execute = [&] (size_t id)
+    {
+      job_result result {id, 0, ""};
+
+      for (const auto& cmd : command_lines[id])
+        {
+          result.status = execute_command (cmd, result.output);
+
+          if (result.status != 0)
+            break;
+        }
+
+      std::lock_guard<std::mutex> lock (mtx);
+
+      finished.push_back (std::move (result));
+
+      cv.notify_one ();
+    };
+
+    size_t started = 0;
+
+    size_t running = 0;
+
+    bool failed = false;
+
+    while (true)
+      {
+        while (! failed && ! ready.empty () && running < static_cast<size_t> (max_jobs))
+          {
+            size_t id = ready.front ();
+
+            ready.pop_front ();
+
+            if (verbose)
+              {
+                octave_stdout << "  [" << ++started << "/" << n << "] " << jobs[id].description << "\n";
+
+                octave_stdout.flush ();
+              }
+
+            workers[id] = std::thread (execute, id);
+
+            running++;
+          }
+
+        if (running == 0)
+          break;
+
+        job_result result;
+
+        {
+          std::unique_lock<std::mutex> lock (mtx);
+
+          while (finished.empty ())
+            {
+              cv.wait_for (lock, std::chrono::milliseconds (100));
+
+              if (finished.empty ())
+                {
+                  lock.unlock ();
+
+                  octave_quit ();
+
+                  lock.lock ();
+                }
+            }
+
+          result = std::move (finished.front ());
+
+          finished.pop_front ();
+        }
+
+        workers[result.id].join ();
+
+        running--;
+
+        if (! result.output.empty ())
+          octave_stdout << result.output;
+
+        if (result.status != 0)
+          {
+            failed = true;
+
+            continue;
+          }
+
+        for (size_t d : dependents[result.id])
+          if (--num_deps[d] == 0)
+            ready.push_back (d);
+      }
+
+    if (failed)
+      error ("coder: compile error");
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace coder_compiler
+{
+  // A job is a sequence of mkoctfile invocations that should be executed in
+  // order. A job is started when all of the jobs that it depends on are
+  // finished successfully.
+
+  struct build_job
+  {
+    using command = std::vector<std::string>;
+
+    std::string description;
+
+    std::vector<command> commands;
+
+    std::vector<size_t> deps;
+
+    bool shared_link;
+  };
+
+  class job_scheduler
+  {
+  public:
+
+    job_scheduler (int max_jobs, bool verbose);
+
+    size_t
+    add_job (
+      const std::string& description,
+      std::vector<build_job::command> commands,
+      std::vector<size_t> deps = {},
+      bool shared_link = false
+    );
+
+    bool
+    empty () const
+    {
+      return jobs.empty ();
+    }
+
+    void
+    run ();
+
+  private:
+
+    void
+    run_serial ();
+
+    void
+    run_parallel ();
+
+    std::vector<build_job> jobs;
+
+    int max_jobs;
+
+    bool verbose;
+  };
+}
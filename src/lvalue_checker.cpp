@@ -668,7 +668,7 @@ namespace coder_compiler
       {
         octave_value::unary_op etype = expr.op_type ();
 
-        if (etype == octave_value::op_incr || etype == octave_value::op_incr)
+        if (etype == octave_value::op_incr || etype == octave_value::op_decr)
           {
             if (lhs->is_index_expression ())
               {
@@ -709,7 +709,7 @@ namespace coder_compiler
       {
         octave_value::unary_op etype = expr.op_type ();
 
-        if (etype == octave_value::op_incr || etype == octave_value::op_incr)
+        if (etype == octave_value::op_incr || etype == octave_value::op_decr)
           {
             if (rhs->is_index_expression ())
               {
@@ -102,6 +102,22 @@ If 'KeepSource' is set to true they aren't deleted.
 The build system internally calls "mkoctfile". Additional options as a character
 string can be set by 'CompilerOptions' to be provided to the compiler through mkoctfile.
 
+@item 'jobs'       :   1 (default)
+
+Maximum number of compile and link jobs that are run in parallel in 'static' and
+'dynamic' modes. Independent object files are compiled concurrently and each
+shared library is linked as soon as the libraries that it depends on are linked.
+When 'verbose' is true the progress of each job is printed.
+
+@item 'profile'    :   false (default) | true
+
+Counts the calls of the compiled functions and the iterations of their loops
+and measures the time spent in them. The .oct file also defines the function
+"coder_profile" that becomes callable after the first call of the compiled
+function. "S = coder_profile ()" returns the profile in the form of the
+result of "profile ('info')" so it can be shown by "profshow (S)" and
+"coder_profile ('clear')" resets it.
+
 @end table
 Example usage:
 
@@ -112,6 +128,8 @@ octave2oct ('my_function', 'outname', 'my_other_function')
 octave2oct ('my_function', 'outname', 'my_other_function',...
             'outdir', 'D:\oct', 'mode', 'dynamic',...
             'cache', 'D:\cache', 'upgrade', true, 'verbose', true)
+octave2oct ('my_function', 'mode', 'static', 'cache', 'D:\cache', 'jobs', 8)
+octave2oct ('my_function', 'profile', true)
 octave2oct ('', 'mode', 'dynamic', 'cache', 'D:\cache',...
             'upgrade', true)
 @end example
@@ -175,6 +193,10 @@ the global and persistent variables of other .oct files.
 
   std::string compiler_options;
 
+  int jobs = 1;
+
+  bool profile = false;
+
   if (names.isempty ())
     {
 
@@ -328,6 +350,17 @@ the global and persistent variables of other .oct files.
             {
               compiler_options = val.xstring_value ("coder: required string as value of \"CompilerOptions\"");
             }
+          else if (option_name == "jobs")
+            {
+              jobs = val.xint_value ("coder: required integer as value of \"jobs\"");
+
+              if (jobs < 1)
+                error ("coder: value of \"jobs\" should be a positive integer");
+            }
+          else if (option_name == "profile")
+            {
+              profile = val.xbool_value ("coder: required bool as value of \"profile\"");
+            }
           else
             error ("coder: invalid option name %s", option_name.c_str ());
         }
@@ -376,7 +409,9 @@ the global and persistent variables of other .oct files.
     debug,
     keepcc,
     verbose,
-    compiler_options);
+    compiler_options,
+    jobs,
+    profile);
 
   return ovl ();
 }
@@ -0,0 +1,727 @@
+#include <octave/oct.h>
+#include <octave/ov-usr-fcn.h>
+#include <octave/version.h>
+
+#include "parfor_analyser.h"
+
+namespace coder_compiler
+{
+  parfor_analyser::parfor_analyser (octave::tree_simple_for_command& cmd)
+  : m_loop_var ()
+  , m_parallel (true)
+  , m_seen ()
+  , m_usage ()
+  , m_temporaries ()
+  , m_reductions ()
+  , m_depth (0)
+  , m_loop_depth (0)
+  {
+    octave::tree_expression *lhs = cmd.left_hand_side ();
+
+    if (! lhs || ! lhs->is_identifier ())
+      {
+        m_parallel = false;
+
+        return;
+      }
+
+    m_loop_var = lhs->name ();
+
+    m_seen.insert (m_loop_var);
+
+    octave::tree_statement_list *body = cmd.body ();
+
+    if (body)
+      body->accept (*this);
+
+    classify ();
+  }
+
+  bool
+  parfor_analyser::reduction_update (octave::tree_simple_assignment& expr)
+  {
+    octave::tree_expression *lhs = expr.left_hand_side ();
+
+    octave::tree_expression *rhs = expr.right_hand_side ();
+
+    if (expr.op_type () != octave_value::op_asn_eq
+        || ! lhs || ! lhs->is_identifier () || ! rhs || ! rhs->is_binary_expression ()
+        || dynamic_cast<octave::tree_boolean_expression *> (rhs)
+        || dynamic_cast<octave::tree_compound_binary_expression *> (rhs))
+      return false;
+
+    octave::tree_binary_expression *bin_expr = static_cast<octave::tree_binary_expression *> (rhs);
+
+    switch (bin_expr->op_type ())
+      {
+      case octave_value::op_add:
+      case octave_value::op_mul:
+      case octave_value::op_el_mul:
+      case octave_value::op_el_and:
+      case octave_value::op_el_or:
+        break;
+
+      default:
+        return false;
+      }
+
+    std::string name = lhs->name ();
+
+    octave::tree_expression *op1 = bin_expr->lhs ();
+
+    octave::tree_expression *op2 = bin_expr->rhs ();
+
+    bool left = op1 && op1->is_identifier () && op1->name () == name;
+
+    bool right = op2 && op2->is_identifier () && op2->name () == name;
+
+    if (! left && ! right)
+      return false;
+
+    octave::tree_expression *operand = left ? op2 : op1;
+
+    if (operand)
+      operand->accept (*this);
+
+    m_seen.insert (name);
+
+    m_usage[name].updates.push_back ({bin_expr->op_type (), left});
+
+    return true;
+  }
+
+  void
+  parfor_analyser::assign (octave::tree_expression *lhs, bool definition)
+  {
+    if (! lhs)
+      return;
+
+    if (lhs->is_identifier ())
+      {
+        std::string name = lhs->name ();
+
+        if (name == "~")
+          return;
+
+        // the first use of a temporary is an unconditional assignment so
+        // it never sees the value of another iteration
+
+        if (definition && ! m_seen.count (name) && m_depth == 1)
+          m_temporaries.insert (name);
+
+        m_seen.insert (name);
+
+        m_usage[name].assigned = true;
+      }
+    else if (lhs->is_index_expression ())
+      index (*static_cast<octave::tree_index_expression *> (lhs), true);
+    else
+      lhs->accept (*this);
+  }
+
+  void
+  parfor_analyser::index (octave::tree_index_expression& expr, bool assignment)
+  {
+    octave::tree_expression *e = expr.expression ();
+
+    std::string type_tags = expr.type_tags ();
+
+    std::list<octave::tree_argument_list *> lst = expr.arg_lists ();
+
+    if (e && e->is_identifier ())
+      {
+        std::string name = e->name ();
+
+        m_seen.insert (name);
+
+        usage& u = m_usage[name];
+
+        u.indexed = true;
+
+        if (assignment)
+          u.index_assigned = true;
+
+        // a slice is selected by the loop variable and constant subscripts
+
+        int position = -1;
+
+        int nargs = 0;
+
+        bool sliced = type_tags == "(" && lst.front ();
+
+        if (sliced)
+          {
+            for (octave::tree_expression *arg : *lst.front ())
+              {
+                if (arg && arg->is_identifier () && arg->name () == m_loop_var
+                    && position == -1)
+                  position = nargs;
+                else if (! arg || ! arg->is_constant ())
+                  sliced = false;
+
+                nargs++;
+              }
+          }
+
+        if (! sliced || position == -1
+            || (u.slice_position != -1
+                && (u.slice_position != position || u.slice_nargs != nargs)))
+          u.sliced = false;
+        else
+          {
+            u.slice_position = position;
+
+            u.slice_nargs = nargs;
+          }
+      }
+    else if (e)
+      e->accept (*this);
+
+    std::list<string_vector> arg_names = expr.arg_names ();
+
+    std::list<octave::tree_expression *> dyn_field = expr.dyn_fields ();
+
+    std::list<octave::tree_argument_list *>::iterator p = lst.begin ();
+
+    std::list<string_vector>::iterator p_arg_names = arg_names.begin ();
+
+    std::list<octave::tree_expression *>::iterator p_dyn_field = dyn_field.begin ();
+
+    int n = type_tags.length ();
+
+    for (int i = 0; i < n; i++)
+      {
+        octave::tree_argument_list *elt = *p++;
+
+        if (type_tags[i] == '.')
+          {
+            string_vector nm = *p_arg_names;
+
+            if (nm.numel () == 1 && nm(0).empty ())
+              {
+                octave::tree_expression *df = *p_dyn_field;
+
+                if (df)
+                  df->accept (*this);
+              }
+          }
+        else if (elt)
+          elt->accept (*this);
+
+        p_arg_names++;
+
+        p_dyn_field++;
+      }
+  }
+
+  void
+  parfor_analyser::classify ()
+  {
+    for (const auto& var : m_usage)
+      {
+        const std::string& name = var.first;
+
+        const usage& u = var.second;
+
+        if (! m_parallel)
+          return;
+
+        if (name == m_loop_var)
+          {
+            m_parallel = ! u.assigned && ! u.index_assigned && u.updates.empty ();
+
+            continue;
+          }
+
+        if (m_temporaries.count (name))
+          continue;
+
+        // broadcast variable
+
+        if (! u.assigned && ! u.index_assigned && u.updates.empty ())
+          continue;
+
+        // sliced output variable
+
+        if (u.index_assigned)
+          {
+            m_parallel = ! u.assigned && ! u.read && u.sliced && u.updates.empty ();
+
+            continue;
+          }
+
+        // reduction variable
+
+        if (! u.assigned && ! u.read && ! u.indexed && ! u.updates.empty ())
+          {
+            const parfor_reduction& first = u.updates.front ();
+
+            for (const parfor_reduction& upd : u.updates)
+              if (upd.op != first.op || upd.left != first.left)
+                m_parallel = false;
+
+            m_reductions[name] = first;
+
+            continue;
+          }
+
+        m_parallel = false;
+      }
+  }
+
+  void
+  parfor_analyser::visit_argument_list (octave::tree_argument_list& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_expression *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  parfor_analyser::visit_binary_expression (octave::tree_binary_expression& expr)
+  {
+    octave::tree_expression *op1 = expr.lhs ();
+
+    if (op1)
+      op1->accept (*this);
+
+    octave::tree_expression *op2 = expr.rhs ();
+
+    if (op2)
+      op2->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_boolean_expression (octave::tree_boolean_expression& expr)
+  {
+    visit_binary_expression (expr);
+  }
+
+  void
+  parfor_analyser::visit_compound_binary_expression (octave::tree_compound_binary_expression& expr)
+  {
+    visit_binary_expression (expr);
+  }
+
+  void
+  parfor_analyser::visit_break_command (octave::tree_break_command&)
+  {
+    if (m_loop_depth == 0)
+      m_parallel = false;
+  }
+
+  void
+  parfor_analyser::visit_colon_expression (octave::tree_colon_expression& expr)
+  {
+    octave::tree_expression *op1 = expr.base ();
+
+    if (op1)
+      op1->accept (*this);
+
+    octave::tree_expression *op3 = expr.increment ();
+
+    if (op3)
+      op3->accept (*this);
+
+    octave::tree_expression *op2 = expr.limit ();
+
+    if (op2)
+      op2->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_decl_command (octave::tree_decl_command&)
+  {
+    // global and persistent variables are shared by the iterations
+
+    m_parallel = false;
+  }
+
+  void
+  parfor_analyser::visit_simple_for_command (octave::tree_simple_for_command& cmd)
+  {
+    octave::tree_expression *expr = cmd.control_expr ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_expression *maxproc = cmd.maxproc_expr ();
+
+    if (maxproc)
+      maxproc->accept (*this);
+
+    assign (cmd.left_hand_side (), true);
+
+    octave::tree_statement_list *list = cmd.body ();
+
+    m_loop_depth++;
+
+    if (list)
+      list->accept (*this);
+
+    m_loop_depth--;
+  }
+
+  void
+  parfor_analyser::visit_complex_for_command (octave::tree_complex_for_command& cmd)
+  {
+    octave::tree_expression *expr = cmd.control_expr ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_argument_list *lhs = cmd.left_hand_side ();
+
+    if (lhs)
+      {
+        for (octave::tree_expression *elt : *lhs)
+          assign (elt, false);
+      }
+
+    octave::tree_statement_list *list = cmd.body ();
+
+    m_loop_depth++;
+
+    if (list)
+      list->accept (*this);
+
+    m_loop_depth--;
+  }
+#if OCTAVE_MAJOR_VERSION >= 7
+  void
+  parfor_analyser::visit_spmd_command (octave::tree_spmd_command& cmd)
+  {
+    octave::tree_statement_list *body = cmd.body ();
+
+    if (body)
+      body->accept (*this);
+  }
+#endif
+  void
+  parfor_analyser::visit_multi_assignment (octave::tree_multi_assignment& expr)
+  {
+    octave::tree_expression *rhs = expr.right_hand_side ();
+
+    if (rhs)
+      rhs->accept (*this);
+
+    octave::tree_argument_list *lhs = expr.left_hand_side ();
+
+    if (lhs)
+      {
+        for (octave::tree_expression *elt : *lhs)
+          assign (elt, true);
+      }
+  }
+
+  void
+  parfor_analyser::visit_index_expression (octave::tree_index_expression& expr)
+  {
+    index (expr, false);
+  }
+
+  void
+  parfor_analyser::visit_matrix (octave::tree_matrix& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_argument_list *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  parfor_analyser::visit_cell (octave::tree_cell& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_argument_list *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  parfor_analyser::visit_simple_assignment (octave::tree_simple_assignment& expr)
+  {
+    if (reduction_update (expr))
+      return;
+
+    octave::tree_expression *rhs = expr.right_hand_side ();
+
+    if (rhs)
+      rhs->accept (*this);
+
+    octave::tree_expression *lhs = expr.left_hand_side ();
+
+    // an operator assignment like x += y also reads x
+
+    if (lhs && expr.op_type () != octave_value::op_asn_eq)
+      lhs->accept (*this);
+
+    assign (lhs, expr.op_type () == octave_value::op_asn_eq);
+  }
+
+  void
+  parfor_analyser::visit_statement (octave::tree_statement& stmt)
+  {
+    octave::tree_command *cmd = stmt.command ();
+
+    if (cmd)
+      cmd->accept (*this);
+    else
+      {
+        octave::tree_expression *expr = stmt.expression ();
+
+        if (expr)
+          expr->accept (*this);
+      }
+  }
+
+  void
+  parfor_analyser::visit_statement_list (octave::tree_statement_list& lst)
+  {
+    m_depth++;
+
+    for (octave::tree_statement *elt : lst)
+      {
+        if (elt)
+          elt->accept (*this);
+      }
+
+    m_depth--;
+  }
+
+  void
+  parfor_analyser::visit_try_catch_command (octave::tree_try_catch_command& cmd)
+  {
+    octave::tree_statement_list *try_code = cmd.body ();
+
+    if (try_code)
+      try_code->accept (*this);
+
+    assign (cmd.identifier (), false);
+
+    octave::tree_statement_list *catch_code = cmd.cleanup ();
+
+    if (catch_code)
+      catch_code->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_unwind_protect_command (octave::tree_unwind_protect_command& cmd)
+  {
+    octave::tree_statement_list *unwind_protect_code = cmd.body ();
+
+    if (unwind_protect_code)
+      unwind_protect_code->accept (*this);
+
+    octave::tree_statement_list *cleanup_code = cmd.cleanup ();
+
+    if (cleanup_code)
+      cleanup_code->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_while_command (octave::tree_while_command& cmd)
+  {
+    octave::tree_expression *expr = cmd.condition ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_statement_list *list = cmd.body ();
+
+    m_loop_depth++;
+
+    if (list)
+      list->accept (*this);
+
+    m_loop_depth--;
+  }
+
+  void
+  parfor_analyser::visit_do_until_command (octave::tree_do_until_command& cmd)
+  {
+    octave::tree_statement_list *list = cmd.body ();
+
+    m_loop_depth++;
+
+    if (list)
+      list->accept (*this);
+
+    m_loop_depth--;
+
+    octave::tree_expression *expr = cmd.condition ();
+
+    if (expr)
+      expr->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_anon_fcn_handle (octave::tree_anon_fcn_handle&  afh )
+  {
+    octave::tree_expression *expr = afh.expression ();
+
+    if (expr)
+      expr->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_identifier (octave::tree_identifier& id)
+  {
+    // functions that access the variables of the caller by name
+
+    static const std::set<std::string> transparency_violations =
+    {
+      "assignin",
+      "clear",
+      "eval",
+      "evalin",
+      "exist",
+      "load",
+      "save",
+      "who",
+      "whos"
+    };
+
+    std::string name = id.name ();
+
+    if (transparency_violations.count (name))
+      m_parallel = false;
+
+    m_seen.insert (name);
+
+    m_usage[name].read = true;
+  }
+
+  void
+  parfor_analyser::visit_if_clause (octave::tree_if_clause& cmd)
+  {
+    octave::tree_expression *expr = cmd.condition ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_statement_list *list = cmd.commands ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_if_command (octave::tree_if_command& cmd)
+  {
+    octave::tree_if_command_list *list = cmd.cmd_list ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_if_command_list (octave::tree_if_command_list& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_if_clause *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  parfor_analyser::visit_switch_case (octave::tree_switch_case& cs)
+  {
+    octave::tree_expression *label = cs.case_label ();
+
+    if (label)
+      label->accept (*this);
+
+    octave::tree_statement_list *list = cs.commands ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_switch_case_list (octave::tree_switch_case_list& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_switch_case *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  parfor_analyser::visit_switch_command (octave::tree_switch_command& cmd)
+  {
+    octave::tree_expression *expr = cmd.switch_value ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_switch_case_list *list = cmd.case_list ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  parfor_analyser::visit_postfix_expression (octave::tree_postfix_expression& expr)
+  {
+    octave::tree_expression *op = expr.operand ();
+
+    if (op)
+      {
+        octave_value::unary_op etype = expr.op_type ();
+
+        op->accept (*this);
+
+        if (etype == octave_value::op_incr || etype == octave_value::op_decr)
+          assign (op, false);
+      }
+  }
+
+  void
+  parfor_analyser::visit_prefix_expression (octave::tree_prefix_expression& expr)
+  {
+    octave::tree_expression *op = expr.operand ();
+
+    if (op)
+      {
+        octave_value::unary_op etype = expr.op_type ();
+
+        op->accept (*this);
+
+        if (etype == octave_value::op_incr || etype == octave_value::op_decr)
+          assign (op, false);
+      }
+  }
+
+  void
+  parfor_analyser::visit_return_command (octave::tree_return_command&)
+  {
+    m_parallel = false;
+  }
+}
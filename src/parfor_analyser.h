@@ -0,0 +1,319 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <octave/pt-all.h>
+
+class octave_value;
+
+class octave_user_function;
+
+class octave_user_script;
+
+namespace coder_compiler
+{
+  // An update of a reduction variable r in the form r = r op expr or
+  // r = expr op r.
+
+  struct parfor_reduction
+  {
+    octave_value::binary_op op;
+
+    bool left;
+  };
+
+  // Classifies the variables of the body of a parfor loop.
+  // The loop variable and the broadcast variables are only read, a
+  // temporary is assigned in the top level statement list of the body before
+  // any other use, a sliced variable is only indexed by the loop variable and
+  // a reduction variable is only used in updates with the same operator.
+  // The iterations of the loop are independent if each variable belongs to
+  // one of these classes and the body doesn't break the loop, return or
+  // use functions like eval that access the variables by name.
+
+  class parfor_analyser : public octave::tree_walker
+  {
+  public:
+
+    explicit parfor_analyser (octave::tree_simple_for_command& cmd);
+
+    bool
+    is_parallel () const
+    {
+      return m_parallel;
+    }
+
+    const std::set<std::string>&
+    temporaries () const
+    {
+      return m_temporaries;
+    }
+
+    const std::map<std::string, parfor_reduction>&
+    reductions () const
+    {
+      return m_reductions;
+    }
+
+    void
+    visit_octave_user_script (octave_user_script&) {}
+
+    void
+    visit_argument_list (octave::tree_argument_list& lst);
+
+    void
+    visit_binary_expression (octave::tree_binary_expression&);
+
+    void
+    visit_boolean_expression (octave::tree_boolean_expression&);
+
+    void
+    visit_compound_binary_expression (octave::tree_compound_binary_expression&);
+
+    void
+    visit_break_command (octave::tree_break_command&);
+
+    void
+    visit_colon_expression (octave::tree_colon_expression&);
+
+    void
+    visit_continue_command (octave::tree_continue_command&) {}
+
+    void
+    visit_decl_command (octave::tree_decl_command&);
+
+    void
+    visit_simple_for_command (octave::tree_simple_for_command& cmd);
+
+    void
+    visit_complex_for_command (octave::tree_complex_for_command&);
+#if OCTAVE_MAJOR_VERSION >= 7
+    void
+    visit_spmd_command (octave::tree_spmd_command&);
+
+    void
+    visit_arguments_block (octave::tree_arguments_block&) {}
+
+    void
+    visit_args_block_attribute_list (octave::tree_args_block_attribute_list&) {}
+
+    void
+    visit_args_block_validation_list (octave::tree_args_block_validation_list&) {}
+
+    void
+    visit_arg_validation (octave::tree_arg_validation&) {}
+
+    void
+    visit_arg_size_spec (octave::tree_arg_size_spec&) {}
+
+    void
+    visit_arg_validation_fcns (octave::tree_arg_validation_fcns&) {}
+#endif
+#if OCTAVE_MAJOR_VERSION < 6
+    void
+    visit_funcall (octave::tree_funcall& /* fc */)
+    { }
+
+    void
+    visit_return_list (octave::tree_return_list&) {}
+#endif
+    void
+    visit_multi_assignment (octave::tree_multi_assignment&);
+
+    void
+    visit_no_op_command (octave::tree_no_op_command&) {}
+
+    void
+    visit_constant (octave::tree_constant&) {}
+
+    void
+    visit_index_expression (octave::tree_index_expression&);
+
+    void
+    visit_matrix (octave::tree_matrix&);
+
+    void
+    visit_cell (octave::tree_cell&);
+
+    void
+    visit_simple_assignment (octave::tree_simple_assignment& expr);
+
+    void
+    visit_statement (octave::tree_statement&);
+
+    void
+    visit_statement_list (octave::tree_statement_list&);
+
+    void
+    visit_try_catch_command (octave::tree_try_catch_command& cmd);
+
+    void
+    visit_unwind_protect_command (octave::tree_unwind_protect_command&);
+
+    void
+    visit_while_command (octave::tree_while_command&);
+
+    void
+    visit_do_until_command (octave::tree_do_until_command&);
+
+    void
+    visit_octave_user_function (octave_user_function&) {}
+
+    void
+    visit_function_def (octave::tree_function_def&) {}
+
+    void
+    visit_anon_fcn_handle (octave::tree_anon_fcn_handle&  afh );
+
+    void
+    visit_identifier (octave::tree_identifier& id);
+
+    void
+    visit_if_clause (octave::tree_if_clause&);
+
+    void
+    visit_if_command (octave::tree_if_command&);
+
+    void
+    visit_if_command_list (octave::tree_if_command_list&);
+
+    void
+    visit_switch_case (octave::tree_switch_case&);
+
+    void
+    visit_switch_case_list (octave::tree_switch_case_list&);
+
+    void
+    visit_switch_command (octave::tree_switch_command&);
+
+    void
+    visit_decl_elt (octave::tree_decl_elt&) {}
+
+    void
+    visit_decl_init_list (octave::tree_decl_init_list&) {}
+
+    void
+    visit_fcn_handle (octave::tree_fcn_handle&) {}
+
+    void
+    visit_parameter_list (octave::tree_parameter_list&) {}
+
+    void
+    visit_postfix_expression (octave::tree_postfix_expression&);
+
+    void
+    visit_prefix_expression (octave::tree_prefix_expression&);
+
+    void
+    visit_return_command (octave::tree_return_command&);
+
+    void
+    visit_superclass_ref (octave::tree_superclass_ref&) {}
+
+    void
+    visit_metaclass_query (octave::tree_metaclass_query&) {}
+
+    void
+    visit_classdef_attribute (octave::tree_classdef_attribute&) {}
+
+    void
+    visit_classdef_attribute_list (octave::tree_classdef_attribute_list&) {}
+
+    void
+    visit_classdef_superclass (octave::tree_classdef_superclass&) {}
+
+    void
+    visit_classdef_superclass_list (octave::tree_classdef_superclass_list&) {}
+
+    void
+    visit_classdef_property (octave::tree_classdef_property&) {}
+
+    void
+    visit_classdef_property_list (octave::tree_classdef_property_list&) {}
+
+    void
+    visit_classdef_properties_block (octave::tree_classdef_properties_block&) {}
+
+    void
+    visit_classdef_methods_list (octave::tree_classdef_methods_list&) {}
+
+    void
+    visit_classdef_methods_block (octave::tree_classdef_methods_block&) {}
+
+    void
+    visit_classdef_event (octave::tree_classdef_event&) {}
+
+    void
+    visit_classdef_events_list (octave::tree_classdef_events_list&) {}
+
+    void
+    visit_classdef_events_block (octave::tree_classdef_events_block&) {}
+
+    void
+    visit_classdef_enum (octave::tree_classdef_enum&) {}
+
+    void
+    visit_classdef_enum_list (octave::tree_classdef_enum_list&) {}
+
+    void
+    visit_classdef_enum_block (octave::tree_classdef_enum_block&) {}
+
+    void
+    visit_classdef_body (octave::tree_classdef_body&) {}
+
+    void
+    visit_classdef (octave::tree_classdef&) {}
+
+  private:
+
+    struct usage
+    {
+      bool assigned = false;
+
+      bool index_assigned = false;
+
+      bool read = false;
+
+      bool indexed = false;
+
+      bool sliced = true;
+
+      int slice_position = -1;
+
+      int slice_nargs = -1;
+
+      std::vector<parfor_reduction> updates;
+    };
+
+    bool
+    reduction_update (octave::tree_simple_assignment& expr);
+
+    void
+    assign (octave::tree_expression *lhs, bool definition);
+
+    void
+    index (octave::tree_index_expression& expr, bool assignment);
+
+    void
+    classify ();
+
+    std::string m_loop_var;
+
+    bool m_parallel;
+
+    std::set<std::string> m_seen;
+
+    std::map<std::string, usage> m_usage;
+
+    std::set<std::string> m_temporaries;
+
+    std::map<std::string, parfor_reduction> m_reductions;
+
+    int m_depth;
+
+    int m_loop_depth;
+  };
+}
@@ -0,0 +1,1025 @@
+#include <algorithm>
+#include <cmath>
+
+#include <octave/oct.h>
+#include <octave/ov-usr-fcn.h>
+#include <octave/version.h>
+
+#include "type_analyser.h"
+
+namespace coder_compiler
+{
+  type_analyser::type_analyser (octave_user_function& fcn)
+  : m_seen ()
+  , m_excluded ()
+  , m_assignments ()
+  , m_loops ()
+  , m_loop_vars ()
+  , m_parallel_ranges ()
+  , m_parfor_temps ()
+  , m_parfors ()
+  , m_parfor_depths ()
+  , m_nparfor (0)
+  , m_scalars ()
+  , m_depth (0)
+  , m_anon_depth (0)
+  , m_predefined ()
+  {
+    static const std::vector<std::string> special_names  =
+    {
+      "isargout",
+      "narginchk",
+      "nargoutchk",
+      "varargin",
+      "varargout",
+      "ans",
+      "end",
+      "~"
+    };
+
+    m_excluded.insert (special_names.begin (), special_names.end ());
+
+    // nargin and nargout are defined when the function is entered. They are
+    // double scalars unless they are assigned or used as functions.
+
+    m_predefined.insert ("nargin");
+
+    m_predefined.insert ("nargout");
+
+    m_seen.insert (m_predefined.begin (), m_predefined.end ());
+
+    octave::tree_parameter_list *param_list = fcn.parameter_list ();
+
+    if (param_list)
+      param_list->accept (*this);
+
+    octave::tree_parameter_list *ret_list = fcn.return_list ();
+
+    if (ret_list)
+      ret_list->accept (*this);
+
+    octave::tree_statement_list *body = fcn.body ();
+
+    if (body)
+      body->accept (*this);
+
+    infer_types ();
+  }
+
+  scalar_type
+  type_analyser::expression_type (octave::tree_expression *expr, const scalar_map& vars)
+  {
+    if (! expr)
+      return st_unknown;
+
+    if (expr->is_identifier ())
+      {
+        auto it = vars.find (expr->name ());
+
+        if (it == vars.end ())
+          return st_unknown;
+
+        return it->second;
+      }
+
+    if (expr->is_constant ())
+      {
+        octave_value val = static_cast<octave::tree_constant *> (expr)->value ();
+
+        if (val.is_real_scalar () && val.is_double_type ()
+            && std::isfinite (val.double_value ()))
+          return st_double;
+
+        if (val.is_bool_scalar ())
+          return st_bool;
+
+        return st_unknown;
+      }
+
+    if (dynamic_cast<octave::tree_compound_binary_expression *> (expr))
+      return st_unknown;
+
+    octave::tree_boolean_expression *bool_expr = dynamic_cast<octave::tree_boolean_expression *> (expr);
+
+    if (bool_expr)
+      {
+        if (expression_type (bool_expr->lhs (), vars) == st_bool
+            && expression_type (bool_expr->rhs (), vars) == st_bool)
+          return st_bool;
+
+        return st_unknown;
+      }
+
+    octave::tree_binary_expression *bin_expr = dynamic_cast<octave::tree_binary_expression *> (expr);
+
+    if (bin_expr)
+      {
+        scalar_type lhs = expression_type (bin_expr->lhs (), vars);
+
+        scalar_type rhs = expression_type (bin_expr->rhs (), vars);
+
+        if (lhs == st_unknown || rhs == st_unknown)
+          return st_unknown;
+
+        switch (bin_expr->op_type ())
+          {
+          case octave_value::op_add:
+          case octave_value::op_sub:
+          case octave_value::op_mul:
+          case octave_value::op_div:
+          case octave_value::op_ldiv:
+          case octave_value::op_el_mul:
+          case octave_value::op_el_div:
+          case octave_value::op_el_ldiv:
+            return st_double;
+
+          case octave_value::op_lt:
+          case octave_value::op_le:
+          case octave_value::op_eq:
+          case octave_value::op_ge:
+          case octave_value::op_gt:
+          case octave_value::op_ne:
+            return st_bool;
+
+          // conversion of NaN to logical is an error so only logical
+          // operands are accepted
+
+          case octave_value::op_el_and:
+          case octave_value::op_el_or:
+            return (lhs == st_bool && rhs == st_bool) ? st_bool : st_unknown;
+
+          // power of a negative number may be complex
+
+          default:
+            return st_unknown;
+          }
+      }
+
+    octave::tree_prefix_expression *pre_expr = dynamic_cast<octave::tree_prefix_expression *> (expr);
+
+    if (pre_expr)
+      {
+        scalar_type op = expression_type (pre_expr->operand (), vars);
+
+        if (op == st_unknown)
+          return st_unknown;
+
+        switch (pre_expr->op_type ())
+          {
+          case octave_value::op_uplus:
+          case octave_value::op_uminus:
+            return st_double;
+
+          case octave_value::op_not:
+            return op == st_bool ? st_bool : st_unknown;
+
+          default:
+            return st_unknown;
+          }
+      }
+
+    octave::tree_postfix_expression *post_expr = dynamic_cast<octave::tree_postfix_expression *> (expr);
+
+    if (post_expr)
+      {
+        switch (post_expr->op_type ())
+          {
+          case octave_value::op_transpose:
+          case octave_value::op_hermitian:
+            return expression_type (post_expr->operand (), vars);
+
+          default:
+            return st_unknown;
+          }
+      }
+
+    return st_unknown;
+  }
+
+  bool
+  type_analyser::is_scalar_range (octave::tree_expression *expr, const scalar_map& vars)
+  {
+    if (! expr || ! expr->is_colon_expression ())
+      return false;
+
+    octave::tree_colon_expression *colon = static_cast<octave::tree_colon_expression *> (expr);
+
+    octave::tree_expression *inc = colon->increment ();
+
+    return expression_type (colon->base (), vars) != st_unknown
+           && expression_type (colon->limit (), vars) != st_unknown
+           && (! inc || expression_type (inc, vars) != st_unknown);
+  }
+
+  void
+  type_analyser::exclude (octave::tree_expression *expr)
+  {
+    if (! expr)
+      return;
+
+    if (expr->is_index_expression ())
+      expr = static_cast<octave::tree_index_expression *> (expr)->expression ();
+
+    if (expr && expr->is_identifier ())
+      {
+        std::string name = expr->name ();
+
+        m_seen.insert (name);
+
+        m_excluded.insert (name);
+      }
+  }
+
+  void
+  type_analyser::check_parfor_scope (const std::string& name)
+  {
+    // a temporary of a parfor loop that is used outside of the loop
+
+    auto it = m_parfor_temps.find (name);
+
+    if (it != m_parfor_temps.end ()
+        && std::find (m_parfors.begin (), m_parfors.end (), it->second) == m_parfors.end ())
+      m_excluded.insert (name);
+  }
+
+  scalar_map
+  type_analyser::scalar_types (const std::set<std::string>& excluded) const
+  {
+    scalar_map scalars;
+
+    for (const auto& name : m_predefined)
+      if (! excluded.count (name))
+        scalars[name] = st_double;
+
+    // The range of a serial loop is accepted even if its bounds aren't
+    // known to be scalars because it is checked at run time.
+
+    auto is_accepted_range = [&](octave::tree_expression *range)
+    {
+      return ! m_parallel_ranges.count (range) || is_scalar_range (range, scalars);
+    };
+
+    // Assume that the type of each variable is the type of its first
+    // definition ...
+
+    bool changed = true;
+
+    while (changed)
+      {
+        changed = false;
+
+        for (const auto& loop : m_loops)
+          {
+            const std::string& name = loop.first;
+
+            if (excluded.count (name) || scalars.count (name))
+              continue;
+
+            if (is_accepted_range (loop.second.front ()))
+              {
+                scalars[name] = st_double;
+
+                changed = true;
+              }
+          }
+
+        for (const auto& asgn : m_assignments)
+          {
+            const std::string& name = asgn.first;
+
+            if (excluded.count (name) || scalars.count (name))
+              continue;
+
+            scalar_type type = expression_type (asgn.second.front (), scalars);
+
+            if (type != st_unknown)
+              {
+                scalars[name] = type;
+
+                changed = true;
+              }
+          }
+      }
+
+    // ... and remove the variables that any of their assignments contradicts
+    // the assumption until all assignments are consistent.
+
+    changed = true;
+
+    while (changed)
+      {
+        changed = false;
+
+        for (auto it = scalars.begin (); it != scalars.end (); )
+          {
+            bool consistent = true;
+
+            auto loop = m_loops.find (it->first);
+
+            if (loop != m_loops.end ())
+              {
+                for (octave::tree_expression *range : loop->second)
+                  if (! is_accepted_range (range))
+                    {
+                      consistent = false;
+
+                      break;
+                    }
+              }
+            else if (! m_predefined.count (it->first))
+              {
+                for (octave::tree_expression *rhs : m_assignments.at (it->first))
+                  if (expression_type (rhs, scalars) != it->second)
+                    {
+                      consistent = false;
+
+                      break;
+                    }
+              }
+
+            if (consistent)
+              ++it;
+            else
+              {
+                it = scalars.erase (it);
+
+                changed = true;
+              }
+          }
+      }
+
+    return scalars;
+  }
+
+  void
+  type_analyser::infer_types ()
+  {
+    // Loop variables that are also assigned are ordinary variables
+
+    for (const auto& loop : m_loops)
+      if (m_assignments.count (loop.first))
+        m_excluded.insert (loop.first);
+
+    for (const auto& name : m_predefined)
+      if (m_assignments.count (name) || m_loops.count (name))
+        m_excluded.insert (name);
+
+    m_scalars = scalar_types (m_excluded);
+
+    // A loop whose bounds turn out not to be real double scalars at run
+    // time falls back to a boxed loop variable. So a loop variable with such
+    // a loop remains a double only if no other variable is a scalar because
+    // of it.
+
+    bool changed = true;
+
+    while (changed)
+      {
+        changed = false;
+
+        for (const auto& loop : m_loops)
+          {
+            const std::string& name = loop.first;
+
+            if (! m_scalars.count (name)
+                || std::all_of (loop.second.begin (), loop.second.end (),
+                                [&](octave::tree_expression *range)
+                                {
+                                  return is_scalar_range (range, m_scalars);
+                                }))
+              continue;
+
+            std::set<std::string> excluded = m_excluded;
+
+            excluded.insert (name);
+
+            scalar_map expected = m_scalars;
+
+            expected.erase (name);
+
+            if (scalar_types (excluded) != expected)
+              {
+                m_excluded.insert (name);
+
+                m_scalars = scalar_types (m_excluded);
+
+                changed = true;
+
+                break;
+              }
+          }
+      }
+  }
+
+  void
+  type_analyser::visit_argument_list (octave::tree_argument_list& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_expression *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_binary_expression (octave::tree_binary_expression& expr)
+  {
+    octave::tree_expression *op1 = expr.lhs ();
+
+    if (op1)
+      op1->accept (*this);
+
+    octave::tree_expression *op2 = expr.rhs ();
+
+    if (op2)
+      op2->accept (*this);
+  }
+
+  void
+  type_analyser::visit_boolean_expression (octave::tree_boolean_expression& expr)
+  {
+    visit_binary_expression (expr);
+  }
+
+  void
+  type_analyser::visit_compound_binary_expression (octave::tree_compound_binary_expression& expr)
+  {
+    visit_binary_expression (expr);
+  }
+
+  void
+  type_analyser::visit_colon_expression (octave::tree_colon_expression& expr)
+  {
+    octave::tree_expression *op1 = expr.base ();
+
+    if (op1)
+      op1->accept (*this);
+
+    octave::tree_expression *op3 = expr.increment ();
+
+    if (op3)
+      op3->accept (*this);
+
+    octave::tree_expression *op2 = expr.limit ();
+
+    if (op2)
+      op2->accept (*this);
+  }
+
+  void
+  type_analyser::visit_decl_command (octave::tree_decl_command& cmd)
+  {
+    octave::tree_decl_init_list *init_list = cmd.initializer_list ();
+
+    if (init_list)
+      init_list->accept (*this);
+  }
+
+  void
+  type_analyser::visit_decl_init_list (octave::tree_decl_init_list& lst)
+  {
+    for (octave::tree_decl_elt *elt : lst)
+      {
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_decl_elt (octave::tree_decl_elt& elt)
+  {
+    octave::tree_expression *expr = elt.expression ();
+
+    if (expr)
+      expr->accept (*this);
+
+    exclude (elt.ident ());
+  }
+
+  void
+  type_analyser::visit_simple_for_command (octave::tree_simple_for_command& cmd)
+  {
+    octave::tree_expression *expr = cmd.control_expr ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_expression *maxproc = cmd.maxproc_expr ();
+
+    if (maxproc)
+      maxproc->accept (*this);
+
+    octave::tree_expression *lhs = cmd.left_hand_side ();
+
+    octave::tree_statement_list *list = cmd.body ();
+
+    bool parallel = cmd.in_parallel ();
+
+    if (parallel)
+      {
+        m_parfors.push_back (m_nparfor++);
+
+        m_parfor_depths.push_back (m_depth + 1);
+      }
+
+    if (lhs && lhs->is_identifier () && expr && expr->is_colon_expression ()
+        && ! maxproc && m_anon_depth == 0)
+      {
+        std::string name = lhs->name ();
+
+        // a variable that is used before its first loop isn't a loop
+        // variable
+
+        if (m_seen.count (name) && ! m_loops.count (name))
+          m_excluded.insert (name);
+
+        m_seen.insert (name);
+
+        m_loops[name].push_back (expr);
+
+        if (parallel)
+          m_parallel_ranges.insert (expr);
+
+        m_loop_vars.push_back (name);
+
+        if (list)
+          list->accept (*this);
+
+        m_loop_vars.pop_back ();
+      }
+    else
+      {
+        if (lhs)
+          {
+            exclude (lhs);
+
+            lhs->accept (*this);
+          }
+
+        if (list)
+          list->accept (*this);
+      }
+
+    if (parallel)
+      {
+        m_parfors.pop_back ();
+
+        m_parfor_depths.pop_back ();
+      }
+  }
+
+  void
+  type_analyser::visit_complex_for_command (octave::tree_complex_for_command& cmd)
+  {
+    octave::tree_expression *expr = cmd.control_expr ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_argument_list *lhs = cmd.left_hand_side ();
+
+    if (lhs)
+      {
+        for (octave::tree_expression *elt : *lhs)
+          exclude (elt);
+
+        lhs->accept (*this);
+      }
+
+    octave::tree_statement_list *list = cmd.body ();
+
+    if (list)
+      list->accept (*this);
+  }
+#if OCTAVE_MAJOR_VERSION >= 7
+  void
+  type_analyser::visit_spmd_command (octave::tree_spmd_command& cmd)
+  {
+    octave::tree_statement_list *body = cmd.body ();
+
+    if (body)
+      body->accept (*this);
+  }
+#endif
+  void
+  type_analyser::visit_multi_assignment (octave::tree_multi_assignment& expr)
+  {
+    octave::tree_expression *rhs = expr.right_hand_side ();
+
+    if (rhs)
+      rhs->accept (*this);
+
+    octave::tree_argument_list *lhs = expr.left_hand_side ();
+
+    if (lhs)
+      {
+        for (octave::tree_expression *elt : *lhs)
+          exclude (elt);
+
+        lhs->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_index_expression (octave::tree_index_expression& expr)
+  {
+    octave::tree_expression *e = expr.expression ();
+
+    exclude (&expr);
+
+    if (e)
+      e->accept (*this);
+
+    std::string type_tags = expr.type_tags ();
+
+    std::list<octave::tree_argument_list *> lst = expr.arg_lists ();
+
+    std::list<string_vector> arg_names = expr.arg_names ();
+
+    std::list<octave::tree_expression *> dyn_field = expr.dyn_fields ();
+
+    std::list<octave::tree_argument_list *>::iterator p = lst.begin ();
+
+    std::list<string_vector>::iterator p_arg_names = arg_names.begin ();
+
+    std::list<octave::tree_expression *>::iterator p_dyn_field = dyn_field.begin ();
+
+    int n = type_tags.length ();
+
+    for (int i = 0; i < n; i++)
+      {
+        octave::tree_argument_list *elt = *p++;
+
+        if (type_tags[i] == '.')
+          {
+            string_vector nm = *p_arg_names;
+
+            if (nm.numel () == 1 && nm(0).empty ())
+              {
+                octave::tree_expression *df = *p_dyn_field;
+
+                if (df)
+                  df->accept (*this);
+              }
+          }
+        else if (elt)
+          elt->accept (*this);
+
+        p_arg_names++;
+
+        p_dyn_field++;
+      }
+  }
+
+  void
+  type_analyser::visit_matrix (octave::tree_matrix& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_argument_list *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_cell (octave::tree_cell& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_argument_list *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_simple_assignment (octave::tree_simple_assignment& expr)
+  {
+    // Assignments that aren't handled by visit_statement
+
+    octave::tree_expression *rhs = expr.right_hand_side ();
+
+    if (rhs)
+      rhs->accept (*this);
+
+    octave::tree_expression *lhs = expr.left_hand_side ();
+
+    if (lhs)
+      {
+        exclude (lhs);
+
+        lhs->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_statement (octave::tree_statement& stmt)
+  {
+    octave::tree_command *cmd = stmt.command ();
+
+    if (cmd)
+      {
+        cmd->accept (*this);
+
+        return;
+      }
+
+    octave::tree_expression *expr = stmt.expression ();
+
+    if (! expr)
+      return;
+
+    octave::tree_simple_assignment *asgn = dynamic_cast<octave::tree_simple_assignment *> (expr);
+
+    if (asgn && asgn->op_type () == octave_value::op_asn_eq)
+      {
+        octave::tree_expression *lhs = asgn->left_hand_side ();
+
+        octave::tree_expression *rhs = asgn->right_hand_side ();
+
+        if (lhs && rhs && lhs->is_identifier ())
+          {
+            rhs->accept (*this);
+
+            std::string name = lhs->name ();
+
+            // the first definition should be executed unconditionally
+
+            if (! m_seen.count (name) && m_depth > 1)
+              {
+                if (! m_parfors.empty () && m_depth == m_parfor_depths.back ())
+                  m_parfor_temps[name] = m_parfors.back ();
+                else
+                  m_excluded.insert (name);
+              }
+
+            check_parfor_scope (name);
+
+            m_seen.insert (name);
+
+            m_assignments[name].push_back (rhs);
+
+            return;
+          }
+      }
+
+    expr->accept (*this);
+  }
+
+  void
+  type_analyser::visit_statement_list (octave::tree_statement_list& lst)
+  {
+    m_depth++;
+
+    for (octave::tree_statement *elt : lst)
+      {
+        if (elt)
+          elt->accept (*this);
+      }
+
+    m_depth--;
+  }
+
+  void
+  type_analyser::visit_try_catch_command (octave::tree_try_catch_command& cmd)
+  {
+    octave::tree_statement_list *try_code = cmd.body ();
+
+    if (try_code)
+      try_code->accept (*this);
+
+    exclude (cmd.identifier ());
+
+    octave::tree_statement_list *catch_code = cmd.cleanup ();
+
+    if (catch_code)
+      catch_code->accept (*this);
+  }
+
+  void
+  type_analyser::visit_unwind_protect_command (octave::tree_unwind_protect_command& cmd)
+  {
+    octave::tree_statement_list *unwind_protect_code = cmd.body ();
+
+    if (unwind_protect_code)
+      unwind_protect_code->accept (*this);
+
+    octave::tree_statement_list *cleanup_code = cmd.cleanup ();
+
+    if (cleanup_code)
+      cleanup_code->accept (*this);
+  }
+
+  void
+  type_analyser::visit_while_command (octave::tree_while_command& cmd)
+  {
+    octave::tree_expression *expr = cmd.condition ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_statement_list *list = cmd.body ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  type_analyser::visit_do_until_command (octave::tree_do_until_command& cmd)
+  {
+    octave::tree_statement_list *list = cmd.body ();
+
+    if (list)
+      list->accept (*this);
+
+    octave::tree_expression *expr = cmd.condition ();
+
+    if (expr)
+      expr->accept (*this);
+  }
+
+  void
+  type_analyser::visit_anon_fcn_handle (octave::tree_anon_fcn_handle&  afh )
+  {
+    // variables that are captured by an anonymous function are kept as
+    // Symbols
+
+    m_anon_depth++;
+
+    octave::tree_parameter_list *param_list = afh.parameter_list ();
+
+    if (param_list)
+      param_list->accept (*this);
+
+    octave::tree_expression *expr = afh.expression ();
+
+    if (expr)
+      expr->accept (*this);
+
+    m_anon_depth--;
+  }
+
+  void
+  type_analyser::visit_fcn_handle (octave::tree_fcn_handle& fh)
+  {
+    // a handle to nargin or nargout refers to the function
+
+    if (m_predefined.count (fh.name ()))
+      m_excluded.insert (fh.name ());
+  }
+
+  void
+  type_analyser::visit_identifier (octave::tree_identifier& id)
+  {
+    std::string name = id.name ();
+
+    if (m_anon_depth > 0 || ! m_seen.count (name))
+      m_excluded.insert (name);
+
+    check_parfor_scope (name);
+
+    // a loop variable that is used outside of its loops
+
+    if (m_loops.count (name)
+        && std::find (m_loop_vars.begin (), m_loop_vars.end (), name) == m_loop_vars.end ())
+      m_excluded.insert (name);
+
+    m_seen.insert (name);
+  }
+
+  void
+  type_analyser::visit_if_clause (octave::tree_if_clause& cmd)
+  {
+    octave::tree_expression *expr = cmd.condition ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_statement_list *list = cmd.commands ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  type_analyser::visit_if_command (octave::tree_if_command& cmd)
+  {
+    octave::tree_if_command_list *list = cmd.cmd_list ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  type_analyser::visit_if_command_list (octave::tree_if_command_list& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_if_clause *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_switch_case (octave::tree_switch_case& cs)
+  {
+    octave::tree_expression *label = cs.case_label ();
+
+    if (label)
+      label->accept (*this);
+
+    octave::tree_statement_list *list = cs.commands ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  type_analyser::visit_switch_case_list (octave::tree_switch_case_list& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_switch_case *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_switch_command (octave::tree_switch_command& cmd)
+  {
+    octave::tree_expression *expr = cmd.switch_value ();
+
+    if (expr)
+      expr->accept (*this);
+
+    octave::tree_switch_case_list *list = cmd.case_list ();
+
+    if (list)
+      list->accept (*this);
+  }
+
+  void
+  type_analyser::visit_parameter_list (octave::tree_parameter_list& lst)
+  {
+    auto p = lst.begin ();
+
+    while (p != lst.end ())
+      {
+        octave::tree_decl_elt *elt = *p++;
+
+        if (elt)
+          elt->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_postfix_expression (octave::tree_postfix_expression& expr)
+  {
+    octave::tree_expression *op = expr.operand ();
+
+    if (op)
+      {
+        octave_value::unary_op etype = expr.op_type ();
+
+        if (etype == octave_value::op_incr || etype == octave_value::op_decr)
+          exclude (op);
+
+        op->accept (*this);
+      }
+  }
+
+  void
+  type_analyser::visit_prefix_expression (octave::tree_prefix_expression& expr)
+  {
+    octave::tree_expression *op = expr.operand ();
+
+    if (op)
+      {
+        octave_value::unary_op etype = expr.op_type ();
+
+        if (etype == octave_value::op_incr || etype == octave_value::op_decr)
+          exclude (op);
+
+        op->accept (*this);
+      }
+  }
+}